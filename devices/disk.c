@@ -1,12 +1,15 @@
 #include "devices/disk.h"
 #include <ctype.h>
 #include <debug.h>
+#include <list.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -32,6 +35,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +51,13 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+
+/* Most sectors moved by a single READ/WRITE command.  The sector
+   count register is 8 bits wide, where 0 means 256. */
+#define MAX_SECTORS_PER_CMD 256
 
 /* An ATA device. */
 struct disk {
@@ -56,6 +67,8 @@ struct disk {
 
 	bool is_ata;                /* 1=This device is an ATA disk. */
 	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
+	int multiple;               /* Sectors per DRQ block in READ/WRITE
+								   MULTIPLE, or 0 if not enabled. */
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
@@ -68,12 +81,38 @@ struct channel {
 	uint16_t reg_base;          /* Base I/O port. */
 	uint8_t irq;                /* Interrupt in use. */
 
-	struct lock lock;           /* Must acquire to access the controller. */
+	struct lock lock;           /* Protects the request queue. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
+
+	/* Request queue, drained by the channel's driver thread, which
+	   is the only thread that touches the controller once the
+	   disks have been identified. */
+	struct list queue;          /* Pending requests, in sector order. */
+	struct condition queue_nonempty;    /* Signaled on submission. */
+	int head_dev;               /* Device last transferred to... */
+	disk_sector_t head_sec;     /* ...and the sector just past it. */
+	size_t depth;               /* Number of requests in `queue'. */
+
+	long long request_cnt;      /* Number of requests submitted. */
+	long long merge_cnt;        /* Requests merged into another's command. */
+	long long command_cnt;      /* Number of commands issued. */
+	long long depth_sum;        /* Sum of queue depths seen on submission. */
+	size_t max_depth;           /* Deepest the queue has been. */
+};
+
+/* A pending transfer, owned by the thread waiting on DONE. */
+struct disk_request {
+	struct list_elem elem;      /* Element in channel's `queue'. */
+	struct disk *disk;          /* Disk to transfer to or from. */
+	disk_sector_t sec_no;       /* First sector. */
+	size_t cnt;                 /* Number of sectors. */
+	uint8_t *buffer;            /* CNT * DISK_SECTOR_SIZE bytes. */
+	bool write;                 /* True to write, false to read. */
+	struct semaphore done;      /* Up'd once the transfer completes. */
 };
 
 /* We support the two "legacy" ATA channels found in a standard PC. */
@@ -84,16 +123,26 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void set_multiple_mode (struct disk *, int block);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
-static void output_sector (struct channel *, const void *);
+static void input_sectors (struct channel *, void *, size_t cnt);
+static void output_sectors (struct channel *, const void *, size_t cnt);
 
 static void wait_until_idle (const struct disk *);
 static bool wait_while_busy (const struct disk *);
 static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
+static void submit_request (struct disk *, disk_sector_t, void *,
+		size_t cnt, bool write);
+static bool request_less (const struct list_elem *,
+		const struct list_elem *, void *aux);
+static void next_batch (struct channel *, struct list *batch);
+static void execute_batch (struct channel *, struct list *batch);
+static thread_func channel_worker NO_RETURN;
+
 static void interrupt_handler (struct intr_frame *);
 
 /* Initialize the disk subsystem and detect disks. */
@@ -122,6 +171,12 @@ disk_init (void) {
 		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		list_init (&c->queue);
+		cond_init (&c->queue_nonempty);
+		c->head_dev = 0;
+		c->head_sec = 0;
+		c->depth = c->max_depth = 0;
+		c->request_cnt = c->merge_cnt = c->command_cnt = c->depth_sum = 0;
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -132,6 +187,7 @@ disk_init (void) {
 
 			d->is_ata = false;
 			d->capacity = 0;
+			d->multiple = 0;
 
 			d->read_cnt = d->write_cnt = 0;
 		}
@@ -150,6 +206,10 @@ disk_init (void) {
 		for (dev_no = 0; dev_no < 2; dev_no++)
 			if (c->devices[dev_no].is_ata)
 				identify_ata_device (&c->devices[dev_no]);
+
+		/* Hand the controller over to its driver thread. */
+		if (c->devices[0].is_ata || c->devices[1].is_ata)
+			thread_create (c->name, PRI_MAX, channel_worker, c);
 	}
 
 	/* DO NOT MODIFY BELOW LINES. */
@@ -162,6 +222,8 @@ disk_print_stats (void) {
 	int chan_no;
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+		struct channel *c = &channels[chan_no];
+		long long avg_depth;
 		int dev_no;
 
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -170,6 +232,14 @@ disk_print_stats (void) {
 				printf ("%s: %lld reads, %lld writes\n",
 						d->name, d->read_cnt, d->write_cnt);
 		}
+
+		if (c->request_cnt == 0)
+			continue;
+		avg_depth = c->depth_sum * 10 / c->request_cnt;
+		printf ("%s: %lld requests, %lld merged, %lld commands, "
+				"queue depth %lld.%lld avg, %zu max\n",
+				c->name, c->request_cnt, c->merge_cnt, c->command_cnt,
+				avg_depth / 10, avg_depth % 10, c->max_depth);
 	}
 }
 
@@ -209,21 +279,7 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
-
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_read_multiple (d, sec_no, buffer, 1);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -233,23 +289,252 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, buffer, 1);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must be kernel memory with room for
+   CNT * DISK_SECTOR_SIZE bytes.  The request is queued for the channel's driver thread,
+   which may merge it with neighboring requests into a single
+   command.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt) {
+	submit_request (d, sec_no, buffer, cnt, false);
+}
+
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D from
+   BUFFER, which must be kernel memory holding CNT *
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has acknowledged receiving the data.
+   Queued like disk_read_multiple().
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no,
+		const void *buffer, size_t cnt) {
+	submit_request (d, sec_no, (void *) buffer, cnt, true);
+}
+
+/* Request queue.
+
+   Callers queue a request on the disk's channel and sleep until
+   the channel's driver thread has carried it out.  The queue is
+   kept sorted by device and sector, and the driver services it
+   in C-LOOK order: it sweeps upward from the last sector it
+   transferred and, once nothing lies ahead, jumps back to the
+   lowest pending sector.  Requests that continue exactly where
+   the one being dispatched ends, on the same disk and in the
+   same direction, ride along in the same command.
+
+   The driver thread moves the data itself, and it runs with no
+   process's page table, so every buffer must be kernel memory.
+   A caller with a user buffer stages it in a kernel page first. */
+
+/* Queues a transfer of CNT sectors between BUFFER and disk D
+   starting at SEC_NO, and waits for it to complete. */
+static void
+submit_request (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt, bool write) {
+	struct disk_request r;
 	struct channel *c;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
+	ASSERT (is_kernel_vaddr (buffer));
+
+	if (cnt == 0)
+		return;
+
+	r.disk = d;
+	r.sec_no = sec_no;
+	r.cnt = cnt;
+	r.buffer = buffer;
+	r.write = write;
+	sema_init (&r.done, 0);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	list_insert_ordered (&c->queue, &r.elem, request_less, NULL);
+	c->depth++;
+	if (c->depth > c->max_depth)
+		c->max_depth = c->depth;
+	c->depth_sum += c->depth;
+	c->request_cnt++;
+	cond_signal (&c->queue_nonempty, &c->lock);
 	lock_release (&c->lock);
+
+	sema_down (&r.done);
 }
-
+
+/* Orders requests by device, then by first sector. */
+static bool
+request_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct disk_request *a = list_entry (a_, struct disk_request, elem);
+	const struct disk_request *b = list_entry (b_, struct disk_request, elem);
+
+	if (a->disk->dev_no != b->disk->dev_no)
+		return a->disk->dev_no < b->disk->dev_no;
+	return a->sec_no < b->sec_no;
+}
+
+/* Moves the next request to service from C's queue to BATCH,
+   followed by every queued request that can be merged into the
+   same command.  Must be called with C's lock held. */
+static void
+next_batch (struct channel *c, struct list *batch) {
+	struct disk_request *first;
+	struct list_elem *e;
+	disk_sector_t end;
+	size_t total;
+
+	ASSERT (!list_empty (&c->queue));
+
+	/* First request at or beyond the head, or the lowest one if
+	   the sweep has run off the end. */
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		if (r->disk->dev_no > c->head_dev
+				|| (r->disk->dev_no == c->head_dev && r->sec_no >= c->head_sec))
+			break;
+	}
+	if (e == list_end (&c->queue))
+		e = list_begin (&c->queue);
+
+	first = list_entry (e, struct disk_request, elem);
+	e = list_remove (e);
+	list_push_back (batch, &first->elem);
+	c->depth--;
+	end = first->sec_no + first->cnt;
+	total = first->cnt;
+
+	/* Absorb requests that pick up where the batch leaves off. */
+	while (e != list_end (&c->queue)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+
+		if (r->disk != first->disk || r->sec_no > end)
+			break;
+		if (r->sec_no == end && r->write == first->write
+				&& total + r->cnt <= MAX_SECTORS_PER_CMD) {
+			e = list_remove (e);
+			list_push_back (batch, &r->elem);
+			c->depth--;
+			c->merge_cnt++;
+			end += r->cnt;
+			total += r->cnt;
+		} else
+			e = list_next (e);
+	}
+
+	c->head_dev = first->disk->dev_no;
+	c->head_sec = end;
+}
+
+/* Carries out the requests in BATCH, which cover a contiguous
+   run of sectors on one disk in one direction, in as few
+   commands as possible.  Each command moves up to
+   MAX_SECTORS_PER_CMD sectors, and with multiple mode enabled
+   the disk interrupts once per block of D->multiple sectors
+   instead of once per sector. */
+static void
+execute_batch (struct channel *c, struct list *batch) {
+	struct list_elem *e = list_begin (batch);
+	struct disk_request *r = list_entry (e, struct disk_request, elem);
+	struct disk *d = r->disk;
+	bool write = r->write;
+	disk_sector_t sec_no = r->sec_no;
+	size_t cnt = 0;
+	size_t ofs = 0;
+	size_t block;
+	uint8_t cmd;
+
+	for (e = list_begin (batch); e != list_end (batch); e = list_next (e))
+		cnt += list_entry (e, struct disk_request, elem)->cnt;
+	e = list_begin (batch);
+
+	block = d->multiple > 0 ? (size_t) d->multiple : 1;
+	if (write)
+		cmd = d->multiple > 0 ? CMD_WRITE_MULTIPLE : CMD_WRITE_SECTOR_RETRY;
+	else
+		cmd = d->multiple > 0 ? CMD_READ_MULTIPLE : CMD_READ_SECTOR_RETRY;
+
+	while (cnt > 0) {
+		size_t cmd_cnt = cnt < MAX_SECTORS_PER_CMD ? cnt : MAX_SECTORS_PER_CMD;
+		size_t left;
+
+		select_sector (d, sec_no, cmd_cnt);
+		issue_pio_command (c, cmd);
+		c->command_cnt++;
+		for (left = cmd_cnt; left > 0; ) {
+			size_t n = left < block ? left : block;
+			size_t done;
+
+			if (!write)
+				sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk %s failed, sector=%"PRDSNu,
+						d->name, write ? "write" : "read", sec_no);
+
+			/* A block may straddle the buffers of several requests. */
+			for (done = 0; done < n; ) {
+				size_t run = r->cnt - ofs < n - done ? r->cnt - ofs : n - done;
+				uint8_t *buffer = r->buffer + ofs * DISK_SECTOR_SIZE;
+
+				if (write)
+					output_sectors (c, buffer, run);
+				else
+					input_sectors (c, buffer, run);
+				done += run;
+				ofs += run;
+				if (ofs == r->cnt && list_next (e) != list_end (batch)) {
+					e = list_next (e);
+					r = list_entry (e, struct disk_request, elem);
+					ofs = 0;
+				}
+			}
+
+			if (write)
+				sema_down (&c->completion_wait);
+			sec_no += n;
+			left -= n;
+		}
+		if (write)
+			d->write_cnt += cmd_cnt;
+		else
+			d->read_cnt += cmd_cnt;
+		cnt -= cmd_cnt;
+	}
+}
+
+/* Driver thread for channel C_: services C_'s request queue
+   forever. */
+static void
+channel_worker (void *c_) {
+	struct channel *c = c_;
+
+	for (;;) {
+		struct list batch;
+
+		list_init (&batch);
+		lock_acquire (&c->lock);
+		while (list_empty (&c->queue))
+			cond_wait (&c->queue_nonempty, &c->lock);
+		next_batch (c, &batch);
+		lock_release (&c->lock);
+
+		execute_batch (c, &batch);
+
+		while (!list_empty (&batch)) {
+			struct disk_request *r = list_entry (list_pop_front (&batch),
+					struct disk_request, elem);
+			sema_up (&r->done);
+		}
+	}
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -364,6 +649,10 @@ identify_ata_device (struct disk *d) {
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	/* Word 47 holds the largest DRQ block READ/WRITE MULTIPLE
+	   supports, if any. */
+	set_multiple_mode (d, id[47] & 0xff);
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -401,18 +690,42 @@ print_ata_string (char *string, size_t size) {
 		printf ("%c", string[i ^ 1]);
 }
 
+/* Enables READ/WRITE MULTIPLE on disk D with BLOCK sectors per
+   DRQ block, rounded down to a power of 2 as the command requires.
+   Leaves multiple mode off if BLOCK is less than 2 or the disk
+   rejects the command. */
+static void
+set_multiple_mode (struct disk *d, int block) {
+	struct channel *c = d->channel;
+
+	while (block & (block - 1))
+		block &= block - 1;
+	if (block < 2)
+		return;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), block);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	if ((inb (reg_status (c)) & STA_ERR) == 0)
+		d->multiple = block;
+}
+
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO to the disk's sector selection registers, to
+   transfer CNT sectors.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
+	ASSERT (cnt > 0 && cnt <= MAX_SECTORS_PER_CMD);
 	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt <= d->capacity - sec_no);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt == MAX_SECTORS_PER_CMD ? 0 : cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -439,13 +752,21 @@ input_sector (struct channel *c, void *sector) {
 	insw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
 }
 
-/* Writes SECTOR to channel C's data register in PIO mode.
-   SECTOR must contain DISK_SECTOR_SIZE bytes. */
+/* Reads CNT sectors from channel C's data register in PIO mode
+   into SECTORS, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes. */
 static void
-output_sector (struct channel *c, const void *sector) {
-	outsw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
+input_sectors (struct channel *c, void *sectors, size_t cnt) {
+	insw (reg_data (c), sectors, cnt * DISK_SECTOR_SIZE / 2);
 }
-
+
+/* Writes CNT sectors from SECTORS to channel C's data register in
+   PIO mode. */
+static void
+output_sectors (struct channel *c, const void *sectors, size_t cnt) {
+	outsw (reg_data (c), sectors, cnt * DISK_SECTOR_SIZE / 2);
+}
+
 /* Low-level ATA primitives. */
 
 /* Wait up to 10 seconds for the controller to become idle, that
@@ -0,0 +1,193 @@
+#include "filesys/dentry.h"
+#include <debug.h>
+#include <hash.h>
+#include <ohash.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "threads/synch.h"
+
+/* Dentry cache.
+
+   Remembers the outcome of looking up a single path component
+   NAME in the directory whose inode lives in sector PARENT, so
+   that resolving the same component again needs neither the
+   directory's inode nor its contents.  Failed lookups are cached
+   too, as negative entries.
+
+   The cache holds a fixed number of entries and evicts the least
+   recently used one when full.  The directory layer keeps it
+   coherent: dir_add() and dir_remove() overwrite the entry for
+   the name they touch, and removing a directory purges every
+   entry cached under it. */
+
+/* Number of cached dentries. */
+#define DENTRY_CNT 256
+
+/* A cached path component. */
+struct dentry {
+	struct ohash_elem hash_elem;         /* Element in `dentries'. */
+	struct list_elem lru_elem;          /* Element in `lru'. */
+	disk_sector_t parent;               /* Containing directory's inode. */
+	disk_sector_t sector;               /* Inode of NAME, if positive. */
+	bool negative;                      /* True if NAME does not exist. */
+	char name[NAME_MAX + 1];            /* Null terminated component. */
+};
+
+static struct dentry dentry_pool[DENTRY_CNT];
+static struct ohash dentries;            /* Cached entries, by key. */
+static struct list lru;                 /* Most recently used first. */
+static struct list free_dentries;       /* Unused entries. */
+static struct lock dentry_lock;         /* Protects everything above. */
+
+static ohash_hash_func dentry_hash;
+static ohash_less_func dentry_less;
+
+/* Initializes the dentry cache. */
+void
+dentry_init (void) {
+	size_t i;
+
+	if (!ohash_init (&dentries, dentry_hash, dentry_less, NULL))
+		PANIC ("dentry cache initialization failed");
+	list_init (&lru);
+	list_init (&free_dentries);
+	lock_init (&dentry_lock);
+	for (i = 0; i < DENTRY_CNT; i++)
+		list_push_back (&free_dentries, &dentry_pool[i].lru_elem);
+}
+
+/* Returns the cached dentry for NAME in PARENT, or a null pointer.
+   Must be called with dentry_lock held. */
+static struct dentry *
+find (disk_sector_t parent, const char *name) {
+	struct dentry key;
+	struct ohash_elem *e;
+
+	key.parent = parent;
+	strlcpy (key.name, name, sizeof key.name);
+	e = ohash_find (&dentries, &key.hash_elem);
+	return e != NULL ? ohash_entry (e, struct dentry, hash_elem) : NULL;
+}
+
+/* Returns the dentry for NAME in PARENT, creating it (and evicting
+   the least recently used entry if the cache is full) if it is not
+   cached yet.  Marks it most recently used.  Must be called with
+   dentry_lock held. */
+static struct dentry *
+get (disk_sector_t parent, const char *name) {
+	struct dentry *d = find (parent, name);
+
+	if (d == NULL) {
+		if (!list_empty (&free_dentries))
+			d = list_entry (list_pop_front (&free_dentries),
+					struct dentry, lru_elem);
+		else {
+			d = list_entry (list_pop_back (&lru), struct dentry, lru_elem);
+			ohash_delete (&dentries, &d->hash_elem);
+		}
+		d->parent = parent;
+		strlcpy (d->name, name, sizeof d->name);
+		ohash_insert (&dentries, &d->hash_elem);
+	} else
+		list_remove (&d->lru_elem);
+	list_push_front (&lru, &d->lru_elem);
+	return d;
+}
+
+/* Looks up NAME in the directory whose inode is in sector PARENT.
+   On DENTRY_POSITIVE, stores the sector of NAME's inode into
+   *SECTORP. */
+enum dentry_result
+dentry_lookup (disk_sector_t parent, const char *name,
+		disk_sector_t *sectorp) {
+	enum dentry_result result = DENTRY_MISS;
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return DENTRY_MISS;
+
+	lock_acquire (&dentry_lock);
+	d = find (parent, name);
+	if (d != NULL) {
+		list_remove (&d->lru_elem);
+		list_push_front (&lru, &d->lru_elem);
+		if (d->negative)
+			result = DENTRY_NEGATIVE;
+		else {
+			*sectorp = d->sector;
+			result = DENTRY_POSITIVE;
+		}
+	}
+	lock_release (&dentry_lock);
+	return result;
+}
+
+/* Records that NAME in PARENT refers to the inode in SECTOR. */
+void
+dentry_insert (disk_sector_t parent, const char *name,
+		disk_sector_t sector) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dentry_lock);
+	d = get (parent, name);
+	d->negative = false;
+	d->sector = sector;
+	lock_release (&dentry_lock);
+}
+
+/* Records that PARENT has no entry named NAME. */
+void
+dentry_insert_negative (disk_sector_t parent, const char *name) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dentry_lock);
+	d = get (parent, name);
+	d->negative = true;
+	lock_release (&dentry_lock);
+}
+
+/* Drops every entry cached under directory PARENT.  Called when
+   PARENT's inode is removed, so that a later inode reusing the
+   sector starts from an empty cache. */
+void
+dentry_purge_dir (disk_sector_t parent) {
+	struct list_elem *e, *next;
+
+	lock_acquire (&dentry_lock);
+	for (e = list_begin (&lru); e != list_end (&lru); e = next) {
+		struct dentry *d = list_entry (e, struct dentry, lru_elem);
+		next = list_next (e);
+		if (d->parent == parent) {
+			ohash_delete (&dentries, &d->hash_elem);
+			list_remove (&d->lru_elem);
+			list_push_back (&free_dentries, &d->lru_elem);
+		}
+	}
+	lock_release (&dentry_lock);
+}
+
+/* Returns a hash value for dentry E's key. */
+static uint64_t
+dentry_hash (const struct ohash_elem *e, void *aux UNUSED) {
+	const struct dentry *d = ohash_entry (e, struct dentry, hash_elem);
+	return hash_string (d->name) ^ hash_int (d->parent);
+}
+
+/* Returns true if dentry A's key precedes dentry B's. */
+static bool
+dentry_less (const struct ohash_elem *a_, const struct ohash_elem *b_,
+		void *aux UNUSED) {
+	const struct dentry *a = ohash_entry (a_, struct dentry, hash_elem);
+	const struct dentry *b = ohash_entry (b_, struct dentry, hash_elem);
+
+	if (a->parent != b->parent)
+		return a->parent < b->parent;
+	return strcmp (a->name, b->name) < 0;
+}
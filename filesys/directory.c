@@ -2,9 +2,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <hash.h>
+#include "filesys/dentry.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -19,6 +22,53 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* In-memory index over the entries of one directory inode.
+ * Every on-disk slot is described by a `struct dir_slot'.  Slots
+ * in use are found by name through NAMES, free slots are kept on
+ * FREE_SLOTS, so lookups, additions and removals never rescan the
+ * directory.  The index is built on first use and lives as long
+ * as the in-memory inode does. */
+struct dir_index {
+	struct hash names;                  /* Slots in use, by name. */
+	struct list free_slots;             /* Slots not in use. */
+	off_t end;                          /* Offset just past the last slot. */
+};
+
+/* One directory entry slot, as seen by the index. */
+struct dir_slot {
+	struct hash_elem hash_elem;         /* Element in `names'. */
+	struct list_elem free_elem;         /* Element in `free_slots'. */
+	off_t ofs;                          /* Byte offset of the entry. */
+	disk_sector_t inode_sector;         /* Sector number of header. */
+	char name[NAME_MAX + 1];            /* Null terminated file name. */
+};
+
+/* Number of entries read per disk access while building an index.
+ * 128 entries span exactly 5 sectors, so full batches are read
+ * straight into the buffer without a bounce copy. */
+#define DIR_INDEX_BATCH 128
+
+/* Protects the contents of every directory, their name indexes
+ * and their dentry cache entries.  Lookups hold it for reading,
+ * dir_add() and dir_remove() for writing.  The file system is
+ * flat, with the root as its only directory, so a per-directory
+ * lock would buy nothing over this one. */
+static struct rwlock dir_lock;
+
+/* Serializes building name indexes, which lookups holding
+ * dir_lock for reading may do concurrently. */
+static struct lock dir_index_lock;
+
+static struct dir_index *dir_get_index (const struct dir *);
+static struct dir_slot *dir_index_find (struct dir_index *, const char *);
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	rwlock_init (&dir_lock);
+	lock_init (&dir_index_lock);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -79,12 +129,29 @@ dir_get_inode (struct dir *dir) {
 static bool
 lookup (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
+	struct dir_index *index;
 	struct dir_entry e;
 	size_t ofs;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	index = dir_get_index (dir);
+	if (index != NULL) {
+		struct dir_slot *slot = dir_index_find (index, name);
+		if (slot == NULL)
+			return false;
+		if (ep != NULL) {
+			ep->inode_sector = slot->inode_sector;
+			strlcpy (ep->name, slot->name, sizeof ep->name);
+			ep->in_use = true;
+		}
+		if (ofsp != NULL)
+			*ofsp = slot->ofs;
+		return true;
+	}
+
+	/* No index (out of memory): scan the directory. */
 	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
 		if (e.in_use && !strcmp (name, e.name)) {
@@ -104,16 +171,38 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
+	disk_sector_t parent, sector;
 	struct dir_entry e;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
+	/* Try the dentry cache before touching the directory.  The
+	 * inode is opened with dir_lock held, so that the file cannot
+	 * be removed and its sectors reused in between. */
+	rwlock_acquire_read (&dir_lock);
+	parent = inode_get_inumber (dir->inode);
+	switch (dentry_lookup (parent, name, &sector)) {
+		case DENTRY_POSITIVE:
+			*inode = inode_open (sector);
+			goto done;
+		case DENTRY_NEGATIVE:
+			*inode = NULL;
+			goto done;
+		case DENTRY_MISS:
+			break;
+	}
+
+	if (lookup (dir, name, &e, NULL)) {
+		dentry_insert (parent, name, e.inode_sector);
 		*inode = inode_open (e.inode_sector);
-	else
+	} else {
+		dentry_insert_negative (parent, name);
 		*inode = NULL;
+	}
 
+done:
+	rwlock_release_read (&dir_lock);
 	return *inode != NULL;
 }
 
@@ -125,6 +214,8 @@ dir_lookup (const struct dir *dir, const char *name,
  * error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+	struct dir_index *index;
+	struct dir_slot *slot = NULL;
 	struct dir_entry e;
 	off_t ofs;
 	bool success = false;
@@ -136,21 +227,39 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
+	rwlock_acquire_write (&dir_lock);
+
 	/* Check that NAME is not in use. */
 	if (lookup (dir, name, NULL, NULL))
 		goto done;
 
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
-			break;
+	index = dir_get_index (dir);
+	if (index != NULL) {
+		/* Take a free slot from the index, or append a new one at
+		 * the current end-of-file. */
+		if (!list_empty (&index->free_slots)) {
+			slot = list_entry (list_pop_front (&index->free_slots),
+					struct dir_slot, free_elem);
+			ofs = slot->ofs;
+		} else {
+			slot = malloc (sizeof *slot);
+			if (slot == NULL)
+				goto done;
+			ofs = slot->ofs = index->end;
+		}
+	} else {
+		/* Set OFS to offset of free slot.
+		 * If there are no free slots, then it will be set to the
+		 * current end-of-file.
+
+		 * inode_read_at() will only return a short read at end of file.
+		 * Otherwise, we'd need to verify that we didn't get a short
+		 * read due to something intermittent such as low memory. */
+		for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+				ofs += sizeof e)
+			if (!e.in_use)
+				break;
+	}
 
 	/* Write slot. */
 	e.in_use = true;
@@ -158,7 +267,25 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	e.inode_sector = inode_sector;
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
+	if (success)
+		dentry_insert (inode_get_inumber (dir->inode), name, inode_sector);
+
+	/* Record the outcome in the index. */
+	if (slot != NULL) {
+		if (success) {
+			slot->inode_sector = inode_sector;
+			strlcpy (slot->name, name, sizeof slot->name);
+			hash_insert (&index->names, &slot->hash_elem);
+			if (ofs == index->end)
+				index->end += sizeof e;
+		} else if (ofs < index->end)
+			list_push_front (&index->free_slots, &slot->free_elem);
+		else
+			free (slot);
+	}
+
 done:
+	rwlock_release_write (&dir_lock);
 	return success;
 }
 
@@ -167,6 +294,7 @@ done:
  * which occurs only if there is no file with the given NAME. */
 bool
 dir_remove (struct dir *dir, const char *name) {
+	struct dir_index *index;
 	struct dir_entry e;
 	struct inode *inode = NULL;
 	bool success = false;
@@ -175,6 +303,8 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	rwlock_acquire_write (&dir_lock);
+
 	/* Find directory entry. */
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
@@ -189,11 +319,24 @@ dir_remove (struct dir *dir, const char *name) {
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
 
-	/* Remove inode. */
+	/* Move its slot to the index's free list. */
+	index = inode_get_dir_index (dir->inode);
+	if (index != NULL) {
+		struct dir_slot *slot = dir_index_find (index, name);
+		ASSERT (slot != NULL && slot->ofs == ofs);
+		hash_delete (&index->names, &slot->hash_elem);
+		list_push_front (&index->free_slots, &slot->free_elem);
+	}
+
+	/* Remove inode, and forget it in the dentry cache both as a
+	 * name in DIR and as a directory of its own. */
 	inode_remove (inode);
+	dentry_insert_negative (inode_get_inumber (dir->inode), name);
+	dentry_purge_dir (e.inode_sector);
 	success = true;
 
 done:
+	rwlock_release_write (&dir_lock);
 	inode_close (inode);
 	return success;
 }
@@ -204,13 +347,142 @@ done:
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
+	bool found = false;
 
+	rwlock_acquire_read (&dir_lock);
 	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	rwlock_release_read (&dir_lock);
+	return found;
+}
+
+/* Returns a hash value for the name of dir_slot E. */
+static uint64_t
+slot_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct dir_slot *slot = hash_entry (e, struct dir_slot, hash_elem);
+	return hash_string (slot->name);
+}
+
+/* Returns true if the name of dir_slot A precedes that of B. */
+static bool
+slot_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct dir_slot *a = hash_entry (a_, struct dir_slot, hash_elem);
+	const struct dir_slot *b = hash_entry (b_, struct dir_slot, hash_elem);
+	return strcmp (a->name, b->name) < 0;
+}
+
+/* Frees dir_slot E; used as a hash destructor. */
+static void
+slot_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct dir_slot, hash_elem));
+}
+
+/* Returns the slot in use named NAME in INDEX, or a null pointer
+ * if there is none. */
+static struct dir_slot *
+dir_index_find (struct dir_index *index, const char *name) {
+	struct dir_slot key;
+	struct hash_elem *e;
+
+	if (strlen (name) > NAME_MAX)
+		return NULL;
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&index->names, &key.hash_elem);
+	return e != NULL ? hash_entry (e, struct dir_slot, hash_elem) : NULL;
+}
+
+/* Reads every entry of the directory in INODE and returns a new
+ * index over them.  Returns a null pointer if memory runs out or
+ * the directory could not be read in full. */
+static struct dir_index *
+dir_index_build (struct inode *inode) {
+	struct dir_index *index = malloc (sizeof *index);
+	struct dir_entry *batch = malloc (DIR_INDEX_BATCH * sizeof *batch);
+	off_t ofs = 0;
+	size_t cnt, i;
+
+	if (index == NULL || batch == NULL
+			|| !hash_init (&index->names, slot_hash, slot_less, NULL)) {
+		free (index);
+		free (batch);
+		return NULL;
+	}
+	list_init (&index->free_slots);
+	index->end = 0;
+
+	do {
+		cnt = inode_read_at (inode, batch, DIR_INDEX_BATCH * sizeof *batch, ofs)
+			/ sizeof *batch;
+		for (i = 0; i < cnt; i++, ofs += sizeof *batch) {
+			struct dir_slot *slot = malloc (sizeof *slot);
+			if (slot == NULL)
+				goto fail;
+			slot->ofs = ofs;
+			if (!batch[i].in_use)
+				list_push_back (&index->free_slots, &slot->free_elem);
+			else {
+				slot->inode_sector = batch[i].inode_sector;
+				strlcpy (slot->name, batch[i].name, sizeof slot->name);
+				/* Keep only the first of duplicate names, as a scan
+				 * would, and never hand the other slot out. */
+				if (hash_insert (&index->names, &slot->hash_elem) != NULL)
+					free (slot);
+			}
+		}
+		index->end = ofs;
+	} while (cnt == DIR_INDEX_BATCH);
+
+	/* A short read before end-of-file means a bounce buffer could
+	 * not be allocated; don't trust a partial index. */
+	if (ofs != inode_length (inode) / (off_t) sizeof *batch * (off_t) sizeof *batch)
+		goto fail;
+
+	free (batch);
+	return index;
+
+fail:
+	dir_index_destroy (index);
+	free (batch);
+	return NULL;
+}
+
+/* Returns the index for DIR's inode, building it on first use.
+ * Returns a null pointer if it cannot be built, in which case
+ * callers fall back to scanning the directory.  Must be called
+ * with dir_lock held. */
+static struct dir_index *
+dir_get_index (const struct dir *dir) {
+	struct dir_index *index = inode_get_dir_index (dir->inode);
+
+	if (index == NULL) {
+		lock_acquire (&dir_index_lock);
+		index = inode_get_dir_index (dir->inode);
+		if (index == NULL) {
+			index = dir_index_build (dir->inode);
+			if (index != NULL)
+				inode_set_dir_index (dir->inode, index);
+		}
+		lock_release (&dir_index_lock);
+	}
+	return index;
+}
+
+/* Destroys INDEX and frees all of its slots.  Called by the inode
+ * layer when the directory's inode is released. */
+void
+dir_index_destroy (struct dir_index *index) {
+	if (index != NULL) {
+		hash_destroy (&index->names, slot_free);
+		while (!list_empty (&index->free_slots))
+			free (list_entry (list_pop_front (&index->free_slots),
+						struct dir_slot, free_elem));
+		free (index);
+	}
 }
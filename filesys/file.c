@@ -1,38 +1,161 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <poll.h>
+#include <stdio.h>
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "filesys/pipe.h"
+#include "devices/input.h"
+#include "threads/slab.h"
 
 /* An open file. */
 struct file
 {
-	struct inode *inode; /* File's inode. */
+	struct inode *inode; /* File's inode, or null for a pipe or the console. */
+	struct pipe *pipe;	 /* Pipe, if this is one end of one. */
+	bool console;		 /* True for one end of the console. */
+	bool writer;		 /* True for a pipe's or the console's write end. */
 	off_t pos;			 /* Current position. */
 	bool deny_write;	 /* Has file_deny_write() been called? */
+	int ref_cnt;		 /* Number of fds sharing this file. */
 };
 
+/* Cache of `struct file's. */
+static struct kmem_cache *file_cache;
+
+/* Initializes the file module. */
+void file_init(void)
+{
+	file_cache = kmem_cache_create("file", sizeof(struct file), NULL);
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
 struct file *
 file_open(struct inode *inode)
 {
-	struct file *file = calloc(1, sizeof *file);
+	struct file *file = kmem_cache_alloc(file_cache);
 	if (inode != NULL && file != NULL)
 	{
 		file->inode = inode;
+		file->pipe = NULL;
+		file->console = false;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	}
 	else
 	{
 		inode_close(inode);
-		free(file);
+		kmem_cache_free(file_cache, file);
 		return NULL;
 	}
 }
 
+/* Returns a new file for one end of PIPE, the write end if
+ * WRITER is true, taking over the caller's reference to that end.
+ * Returns a null pointer, and closes the end, if an allocation
+ * fails. */
+static struct file *
+open_pipe_end(struct pipe *pipe, bool writer)
+{
+	struct file *file = kmem_cache_alloc(file_cache);
+	if (file == NULL)
+	{
+		pipe_close(pipe, writer);
+		return NULL;
+	}
+	file->inode = NULL;
+	file->pipe = pipe;
+	file->console = false;
+	file->writer = writer;
+	file->pos = 0;
+	file->deny_write = false;
+	file->ref_cnt = 1;
+	return file;
+}
+
+/* Creates a pipe and stores a file for its read end in *READ_END
+ * and one for its write end in *WRITE_END.  Returns false if
+ * memory is not available. */
+bool file_open_pipe(struct file **read_end, struct file **write_end)
+{
+	struct pipe *pipe = pipe_create();
+	if (pipe == NULL)
+		return false;
+
+	*read_end = open_pipe_end(pipe, false);
+	*write_end = open_pipe_end(pipe, true);
+	if (*read_end == NULL || *write_end == NULL)
+	{
+		file_close(*read_end);
+		file_close(*write_end);
+		return false;
+	}
+	return true;
+}
+
+/* Returns a new file for the console, its output end if WRITER
+ * is true and its keyboard input end otherwise, or a null pointer
+ * if memory is not available. */
+struct file *
+file_open_console(bool writer)
+{
+	struct file *file = kmem_cache_alloc(file_cache);
+	if (file == NULL)
+		return NULL;
+	file->inode = NULL;
+	file->pipe = NULL;
+	file->console = true;
+	file->writer = writer;
+	file->pos = 0;
+	file->deny_write = false;
+	file->ref_cnt = 1;
+	return file;
+}
+
+/* Reads keys from the keyboard into the IOVCNT buffers in IOV, in
+ * order, waiting for each, until the buffers are full or a
+ * newline has been read.  Returns the number of bytes read. */
+static off_t
+console_readv(const struct iovec *iov, int iovcnt)
+{
+	off_t bytes_read = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		char *buf = iov[i].iov_base;
+		size_t ofs;
+
+		for (ofs = 0; ofs < iov[i].iov_len; ofs++)
+		{
+			buf[ofs] = input_getc();
+			bytes_read++;
+			if (buf[ofs] == '\n')
+				return bytes_read;
+		}
+	}
+	return bytes_read;
+}
+
+/* Writes the IOVCNT buffers in IOV, in order, to the console.
+ * Returns the number of bytes written. */
+static off_t
+console_writev(const struct iovec *iov, int iovcnt)
+{
+	off_t bytes_written = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		putbuf(iov[i].iov_base, iov[i].iov_len);
+		bytes_written += iov[i].iov_len;
+	}
+	return bytes_written;
+}
+
 /* Opens and returns a new file for the same inode as FILE.
  * Returns a null pointer if unsuccessful. */
 struct file *
@@ -46,6 +169,14 @@ file_reopen(struct file *file)
 struct file *
 file_duplicate(struct file *file)
 {
+	if (file->pipe != NULL)
+	{
+		pipe_reopen(file->pipe, file->writer);
+		return open_pipe_end(file->pipe, file->writer);
+	}
+	if (file->console)
+		return file_open_console(file->writer);
+
 	struct file *nfile = file_open(inode_reopen(file->inode));
 	if (nfile)
 	{
@@ -56,18 +187,47 @@ file_duplicate(struct file *file)
 	return nfile;
 }
 
+/* Returns FILE, which must be open, with one more reference, for
+ * another fd to share along with its position.  file_close()
+ * drops one reference and only closes FILE with the last. */
+struct file *
+file_share(struct file *file)
+{
+	ASSERT(file->ref_cnt > 0);
+	file->ref_cnt++;
+	return file;
+}
+
+/* Returns true if FILE is one end of a pipe. */
+bool file_is_pipe(struct file *file)
+{
+	return file->pipe != NULL;
+}
+
+/* Returns true if more than one fd shares FILE. */
+bool file_is_shared(struct file *file)
+{
+	return file->ref_cnt > 1;
+}
+
 /* Closes FILE. */
 void file_close(struct file *file)
 {
-	if (file != NULL)
+	if (file != NULL && --file->ref_cnt == 0)
 	{
-		file_allow_write(file);
-		inode_close(file->inode);
-		free(file);
+		if (file->pipe != NULL)
+			pipe_close(file->pipe, file->writer);
+		else if (!file->console)
+		{
+			file_allow_write(file);
+			inode_close(file->inode);
+		}
+		kmem_cache_free(file_cache, file);
 	}
 }
 
-/* Returns the inode encapsulated by FILE. */
+/* Returns the inode encapsulated by FILE, or a null pointer if
+ * FILE is a pipe or the console. */
 struct inode *
 file_get_inode(struct file *file)
 {
@@ -81,6 +241,12 @@ file_get_inode(struct file *file)
  * Advances FILE's position by the number of bytes read. */
 off_t file_read(struct file *file, void *buffer, off_t size)
 {
+	if (file->inode == NULL)
+	{
+		struct iovec iov = {buffer, size};
+		return file_readv(file, &iov, 1);
+	}
+
 	off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
 	return bytes_read;
@@ -90,9 +256,13 @@ off_t file_read(struct file *file, void *buffer, off_t size)
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually read,
  * which may be less than SIZE if end of file is reached.
- * The file's current position is unaffected. */
+ * The file's current position is unaffected.
+ * Returns -1 if FILE is a pipe or the console, which have no
+ * positions. */
 off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs)
 {
+	if (file->inode == NULL)
+		return -1;
 	return inode_read_at(file->inode, buffer, size, file_ofs);
 }
 
@@ -105,6 +275,12 @@ off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs)
  * Advances FILE's position by the number of bytes read. */
 off_t file_write(struct file *file, const void *buffer, off_t size)
 {
+	if (file->inode == NULL)
+	{
+		struct iovec iov = {(void *)buffer, size};
+		return file_writev(file, &iov, 1);
+	}
+
 	off_t bytes_written = inode_write_at(file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
@@ -116,13 +292,106 @@ off_t file_write(struct file *file, const void *buffer, off_t size)
  * which may be less than SIZE if end of file is reached.
  * (Normally we'd grow the file in that case, but file growth is
  * not yet implemented.)
- * The file's current position is unaffected. */
+ * The file's current position is unaffected.
+ * Returns -1 if FILE is a pipe or the console, which have no
+ * positions. */
 off_t file_write_at(struct file *file, const void *buffer, off_t size,
 					off_t file_ofs)
 {
+	if (file->inode == NULL)
+		return -1;
 	return inode_write_at(file->inode, buffer, size, file_ofs);
 }
 
+/* Reads from FILE into the IOVCNT buffers in IOV, in order,
+ * starting at the file's current position, as a single read.
+ * Returns the number of bytes actually read, which may be less
+ * than the buffers' total length if end of file is reached.
+ * Advances FILE's position by the number of bytes read.
+ * A pipe's read end waits for data instead, as pipe_readv(), and
+ * the console's reads keys as console_readv(); their write ends
+ * cannot be read, and return -1. */
+off_t file_readv(struct file *file, const struct iovec *iov, int iovcnt)
+{
+	if (file->pipe != NULL)
+		return file->writer ? -1 : pipe_readv(file->pipe, iov, iovcnt);
+	if (file->console)
+		return file->writer ? -1 : console_readv(iov, iovcnt);
+
+	off_t bytes_read = inode_readv_at(file->inode, iov, iovcnt, file->pos);
+	file->pos += bytes_read;
+	return bytes_read;
+}
+
+/* Writes the IOVCNT buffers in IOV, in order, into FILE,
+ * starting at the file's current position, as a single write.
+ * Returns the number of bytes actually written, which may be
+ * less than the buffers' total length if end of file is reached.
+ * Advances FILE's position by the number of bytes written.
+ * A pipe's write end waits for room instead, as pipe_writev(), and
+ * the console's goes to the display; their read ends cannot be
+ * written, and return -1. */
+off_t file_writev(struct file *file, const struct iovec *iov, int iovcnt)
+{
+	if (file->pipe != NULL)
+		return file->writer ? pipe_writev(file->pipe, iov, iovcnt) : -1;
+	if (file->console)
+		return file->writer ? console_writev(iov, iovcnt) : -1;
+
+	off_t bytes_written = inode_writev_at(file->inode, iov, iovcnt, file->pos);
+	file->pos += bytes_written;
+	return bytes_written;
+}
+
+/* Reads from FILE into the IOVCNT buffers in IOV, in order,
+ * starting at offset FILE_OFS in the file, as a single read.
+ * Returns the number of bytes actually read, which may be less
+ * than the buffers' total length if end of file is reached.
+ * The file's current position is unaffected.
+ * Returns -1 if FILE is a pipe or the console, which have no
+ * positions. */
+off_t file_readv_at(struct file *file, const struct iovec *iov, int iovcnt,
+					off_t file_ofs)
+{
+	if (file->inode == NULL)
+		return -1;
+	return inode_readv_at(file->inode, iov, iovcnt, file_ofs);
+}
+
+/* Writes the IOVCNT buffers in IOV, in order, into FILE, starting
+ * at offset FILE_OFS in the file, as a single write.
+ * Returns the number of bytes actually written, which may be
+ * less than the buffers' total length if end of file is reached.
+ * The file's current position is unaffected.
+ * Returns -1 if FILE is a pipe or the console, which have no
+ * positions. */
+off_t file_writev_at(struct file *file, const struct iovec *iov, int iovcnt,
+					 off_t file_ofs)
+{
+	if (file->inode == NULL)
+		return -1;
+	return inode_writev_at(file->inode, iov, iovcnt, file_ofs);
+}
+
+/* Copies SIZE bytes from SRC into DST, from and to each file's
+ * current position, without passing through user memory.  The
+ * two files must not be open on overlapping ranges of the same
+ * inode.  Returns the number of bytes actually copied, which may
+ * be less than SIZE if end of either file is reached.  Advances
+ * both positions by the number of bytes copied.  Returns -1 if
+ * either file is a pipe or the console. */
+off_t file_copy_range(struct file *dst, struct file *src, off_t size)
+{
+	if (dst->inode == NULL || src->inode == NULL)
+		return -1;
+
+	off_t bytes_copied = inode_copy_range(dst->inode, dst->pos, src->inode,
+										  src->pos, size);
+	dst->pos += bytes_copied;
+	src->pos += bytes_copied;
+	return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void file_deny_write(struct file *file)
@@ -149,10 +418,32 @@ void file_allow_write(struct file *file)
 	}
 }
 
-/* Returns the size of FILE in bytes. */
+/* Returns the poll() events that hold for FILE, as pipe_poll() if
+ * FILE is a pipe, adding ENTRY to the pipe's wait queue if ENTRY
+ * is not null.  The console's input end is readable once a key is
+ * waiting, and waits with input_poll(); its output end is always
+ * writable.  Reads and writes of a regular file never wait for
+ * another process, so it is always ready both ways and ENTRY is
+ * left alone. */
+short file_poll(struct file *file, struct waitq_entry *entry)
+{
+	ASSERT(file != NULL);
+	if (file->pipe != NULL)
+		return pipe_poll(file->pipe, file->writer, entry);
+	if (file->console && !file->writer)
+		return input_poll(entry) ? POLLIN : 0;
+	if (file->console)
+		return POLLOUT;
+	return POLLIN | POLLOUT;
+}
+
+/* Returns the size of FILE in bytes, or -1 if FILE is a pipe or
+ * the console. */
 off_t file_length(struct file *file)
 {
 	ASSERT(file != NULL);
+	if (file->inode == NULL)
+		return -1;
 	return inode_length(file->inode);
 }
 
@@ -6,11 +6,17 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/dentry.h"
 #include "devices/disk.h"
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
 
+/* Root directory, held open for as long as the file system is
+ * mounted so that its inode, and the name index built on it,
+ * stay resident between lookups. */
+static struct dir *root_dir;
+
 static void do_format(void);
 
 /* Initializes the file system module.
@@ -22,6 +28,9 @@ void filesys_init(bool format)
 		PANIC("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init();
+	file_init();
+	dir_init();
+	dentry_init();
 
 #ifdef EFILESYS
 	fat_init();
@@ -39,12 +48,16 @@ void filesys_init(bool format)
 
 	free_map_open();
 #endif
+
+	root_dir = dir_open_root();
 }
 
 /* Shuts down the file system module, writing any unwritten data
  * to disk. */
 void filesys_done(void)
 {
+	dir_close(root_dir);
+
 	/* Original FS */
 #ifdef EFILESYS
 	fat_close();
@@ -60,11 +73,10 @@ void filesys_done(void)
 bool filesys_create(const char *name, off_t initial_size)
 {
 	disk_sector_t inode_sector = 0;
-	struct dir *dir = dir_open_root();
+	struct dir *dir = root_dir;
 	bool success = (dir != NULL && free_map_allocate(1, &inode_sector) && inode_create(inode_sector, initial_size) && dir_add(dir, name, inode_sector));
 	if (!success && inode_sector != 0)
 		free_map_release(inode_sector, 1);
-	dir_close(dir);
 
 	return success;
 }
@@ -77,12 +89,13 @@ bool filesys_create(const char *name, off_t initial_size)
 struct file *
 filesys_open(const char *name)
 {
-	struct dir *dir = dir_open_root();
+	struct dir *dir = root_dir;
 	struct inode *inode = NULL;
 
+	/* The root directory is already open, and dir_lookup() answers
+	 * repeated names from the dentry cache. */
 	if (dir != NULL)
 		dir_lookup(dir, name, &inode);
-	dir_close(dir);
 
 	return file_open(inode);
 }
@@ -93,9 +106,8 @@ filesys_open(const char *name)
  * or if an internal memory allocation fails. */
 bool filesys_remove(const char *name)
 {
-	struct dir *dir = dir_open_root();
+	struct dir *dir = root_dir;
 	bool success = dir != NULL && dir_remove(dir, name);
-	dir_close(dir);
 
 	return success;
 }
@@ -1,5 +1,6 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -87,7 +88,7 @@ fsutil_put (char **argv) {
 	printf ("Putting '%s' into the file system...\n", file_name);
 
 	/* Allocate buffer. */
-	buffer = malloc (DISK_SECTOR_SIZE);
+	buffer = palloc_get_page (0);
 	if (buffer == NULL)
 		PANIC ("couldn't allocate buffer");
 
@@ -111,10 +112,14 @@ fsutil_put (char **argv) {
 	if (dst == NULL)
 		PANIC ("%s: open failed", file_name);
 
-	/* Do copy. */
+	/* Do copy, a page of sectors at a time.  Each chunk but the
+	 * last is whole sectors at a sector-aligned file offset, so
+	 * file_write() sends it straight from BUFFER to disk. */
 	while (size > 0) {
-		int chunk_size = size > DISK_SECTOR_SIZE ? DISK_SECTOR_SIZE : size;
-		disk_read (src, sector++, buffer);
+		int chunk_size = size > PGSIZE ? PGSIZE : size;
+		size_t sectors = DIV_ROUND_UP (chunk_size, DISK_SECTOR_SIZE);
+		disk_read_multiple (src, sector, buffer, sectors);
+		sector += sectors;
 		if (file_write (dst, buffer, chunk_size) != chunk_size)
 			PANIC ("%s: write failed with %"PROTd" bytes unwritten",
 					file_name, size);
@@ -123,7 +128,7 @@ fsutil_put (char **argv) {
 
 	/* Finish up. */
 	file_close (dst);
-	free (buffer);
+	palloc_free_page (buffer);
 }
 
 /* Copies file FILE_NAME from the file system to the scratch disk.
@@ -150,7 +155,7 @@ fsutil_get (char **argv) {
 	printf ("Getting '%s' from the file system...\n", file_name);
 
 	/* Allocate buffer. */
-	buffer = malloc (DISK_SECTOR_SIZE);
+	buffer = palloc_get_page (0);
 	if (buffer == NULL)
 		PANIC ("couldn't allocate buffer");
 
@@ -171,19 +176,23 @@ fsutil_get (char **argv) {
 	((int32_t *) buffer)[1] = size;
 	disk_write (dst, sector++, buffer);
 
-	/* Do copy. */
+	/* Do copy, a page of sectors at a time, reading whole sectors
+	 * of the file straight into BUFFER as in fsutil_put(). */
 	while (size > 0) {
-		int chunk_size = size > DISK_SECTOR_SIZE ? DISK_SECTOR_SIZE : size;
-		if (sector >= disk_size (dst))
+		int chunk_size = size > PGSIZE ? PGSIZE : size;
+		size_t sectors = DIV_ROUND_UP (chunk_size, DISK_SECTOR_SIZE);
+		if (sector + sectors > disk_size (dst))
 			PANIC ("%s: out of space on scratch disk", file_name);
 		if (file_read (src, buffer, chunk_size) != chunk_size)
 			PANIC ("%s: read failed with %"PROTd" bytes unread", file_name, size);
-		memset (buffer + chunk_size, 0, DISK_SECTOR_SIZE - chunk_size);
-		disk_write (dst, sector++, buffer);
+		memset (buffer + chunk_size, 0,
+				sectors * DISK_SECTOR_SIZE - chunk_size);
+		disk_write_multiple (dst, sector, buffer, sectors);
+		sector += sectors;
 		size -= chunk_size;
 	}
 
 	/* Finish up. */
 	file_close (src);
-	free (buffer);
+	palloc_free_page (buffer);
 }
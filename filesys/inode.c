@@ -1,11 +1,18 @@
 #include "filesys/inode.h"
 #include <list.h>
+#include <hash.h>
+#include <ohash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/directory.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -26,13 +33,30 @@ bytes_to_sectors (off_t size) {
 	return DIV_ROUND_UP (size, DISK_SECTOR_SIZE);
 }
 
-/* In-memory inode. */
+/* In-memory inode.
+ *
+ * The members up to `removed' are protected by inode_table_lock.
+ * The rest are protected by `rwlock': readers of the inode's data
+ * hold it for reading, writers and the opener that loads `data'
+ * from disk hold it for writing.  Nothing done under `rwlock' may
+ * touch user memory: a page fault there can lazily load a page
+ * from a file, perhaps this very one, and so would need `rwlock'
+ * again.  Callers therefore pass kernel buffers only, as asserted
+ * by inode_readv_at() and inode_writev_at().  `dir_index' belongs
+ * to the directory layer, which does its own locking.
+ * `exec_layout' belongs to the program loader, which reads it
+ * only while it has writes to the inode denied; any write
+ * discards it. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct ohash_elem elem;              /* Element in open inode table. */
+	struct list_elem closed_elem;       /* Element in closed inode list. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
+	struct rwlock rwlock;               /* Protects the members below. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct dir_index *dir_index;        /* Name index, if a directory. */
+	struct exec_layout *exec_layout;    /* Loader's cache, if a program. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -49,14 +73,41 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 		return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Table of in-memory inodes, keyed by sector, so that opening a
+ * single inode twice returns the same `struct inode'.  Besides the
+ * open inodes it holds up to CLOSED_INODE_CNT recently closed ones
+ * (open_cnt == 0), so that reopening a hot file needs no disk
+ * read.  Those are also on closed_inodes, least recently closed
+ * at the front. */
+static struct ohash open_inodes;
+static struct list closed_inodes;
+static size_t closed_inode_cnt;
+
+/* Protects the inode table, the closed inode list, and the
+ * open_cnt and removed members of every inode.  Never held across
+ * disk I/O. */
+static struct lock inode_table_lock;
+
+/* Number of closed inodes kept in memory. */
+#define CLOSED_INODE_CNT 32
+
+/* Cache of `struct inode's. */
+static struct kmem_cache *inode_cache;
+
+static uint64_t inode_hash (const struct ohash_elem *, void *);
+static bool inode_less (const struct ohash_elem *, const struct ohash_elem *,
+		void *);
+static void inode_free (struct inode *);
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	if (!ohash_init (&open_inodes, inode_hash, inode_less, NULL))
+		PANIC ("inode table initialization failed");
+	list_init (&closed_inodes);
+	closed_inode_cnt = 0;
+	lock_init (&inode_table_lock);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,39 +152,65 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	struct ohash_elem *e;
+	struct inode key;
 	struct inode *inode;
 
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
+	/* Check whether this inode is already in memory. */
+	key.sector = sector;
+	lock_acquire (&inode_table_lock);
+	e = ohash_find (&open_inodes, &key.elem);
+	if (e != NULL) {
+		inode = ohash_entry (e, struct inode, elem);
+		if (inode->open_cnt == 0) {
+			/* Revive a recently closed inode. */
+			list_remove (&inode->closed_elem);
+			closed_inode_cnt--;
 		}
+		inode->open_cnt++;
+		lock_release (&inode_table_lock);
+
+		/* Wait for the opener that is still reading it from disk,
+		 * if any. */
+		rwlock_acquire_read (&inode->rwlock);
+		rwlock_release_read (&inode->rwlock);
+		return inode;
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	inode = kmem_cache_alloc (inode_cache);
+	if (inode == NULL) {
+		lock_release (&inode_table_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize, and publish the inode with its rwlock held for
+	 * writing, so that other openers can find it while its disk
+	 * inode is read without the table lock held. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
-	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init (&inode->rwlock);
+	inode->deny_write_cnt = 0;
+	inode->dir_index = NULL;
+	inode->exec_layout = NULL;
+	rwlock_acquire_write (&inode->rwlock);
+	ohash_insert (&open_inodes, &inode->elem);
+	lock_release (&inode_table_lock);
+
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	rwlock_release_write (&inode->rwlock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&inode_table_lock);
 		inode->open_cnt++;
+		lock_release (&inode_table_lock);
+	}
 	return inode;
 }
 
@@ -143,45 +220,184 @@ inode_get_inumber (const struct inode *inode) {
 	return inode->sector;
 }
 
+/* Returns the directory name index attached to INODE, or a null
+ * pointer if none has been built yet. */
+struct dir_index *
+inode_get_dir_index (const struct inode *inode) {
+	return inode->dir_index;
+}
+
+/* Attaches directory name index INDEX to INODE.  INODE takes
+ * ownership of INDEX and destroys it when INODE leaves memory. */
+void
+inode_set_dir_index (struct inode *inode, struct dir_index *index) {
+	ASSERT (inode->dir_index == NULL);
+	inode->dir_index = index;
+}
+
+/* Returns the executable layout cached on INODE, or a null
+ * pointer if there is none.  The layout stays valid only while
+ * the caller keeps writes to INODE denied. */
+struct exec_layout *
+inode_get_exec_layout (struct inode *inode) {
+	struct exec_layout *layout;
+
+	rwlock_acquire_read (&inode->rwlock);
+	layout = inode->exec_layout;
+	rwlock_release_read (&inode->rwlock);
+	return layout;
+}
+
+/* Caches executable layout LAYOUT, which must have come from
+ * malloc(), on INODE, which takes ownership of it and frees it
+ * when INODE leaves memory or is written.  If another layout was
+ * cached first, frees LAYOUT instead.  Returns the layout that is
+ * cached. */
+struct exec_layout *
+inode_set_exec_layout (struct inode *inode, struct exec_layout *layout) {
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->exec_layout == NULL)
+		inode->exec_layout = layout;
+	else {
+		free (layout);
+		layout = inode->exec_layout;
+	}
+	rwlock_release_write (&inode->rwlock);
+	return layout;
+}
+
 /* Closes INODE and writes it to disk.
- * If this was the last reference to INODE, frees its memory.
- * If INODE was also a removed inode, frees its blocks. */
+ * If this was the last reference to INODE, moves it to the cache
+ * of recently closed inodes, or frees its memory and blocks if
+ * INODE was also a removed inode. */
 void
 inode_close (struct inode *inode) {
+	struct inode *victim = NULL;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
+	/* Release resources if this was the last opener.  Unlink the
+	 * inode from the table under the lock, but free it after
+	 * dropping the lock; nobody else can reach it by then. */
+	lock_acquire (&inode_table_lock);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
 		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+			/* Deallocate blocks if removed. */
+			ohash_delete (&open_inodes, &inode->elem);
+			victim = inode;
+		} else {
+			/* Otherwise keep it around for a quick reopen, evicting
+			 * the least recently closed inode if there are too
+			 * many. */
+			list_push_back (&closed_inodes, &inode->closed_elem);
+			if (++closed_inode_cnt > CLOSED_INODE_CNT) {
+				victim = list_entry (list_pop_front (&closed_inodes),
+						struct inode, closed_elem);
+				closed_inode_cnt--;
+				ohash_delete (&open_inodes, &victim->elem);
+			}
 		}
+	}
+	lock_release (&inode_table_lock);
 
-		free (inode); 
+	if (victim != NULL) {
+		if (victim->removed) {
+			free_map_release (victim->sector, 1);
+			free_map_release (victim->data.start,
+					bytes_to_sectors (victim->data.length)); 
+		}
+		inode_free (victim);
 	}
 }
 
+/* Frees INODE, which must have no openers and must already be
+ * out of the inode table, along with its directory index and
+ * executable layout. */
+static void
+inode_free (struct inode *inode) {
+	ASSERT (inode->open_cnt == 0);
+	dir_index_destroy (inode->dir_index);
+	free (inode->exec_layout);
+	kmem_cache_free (inode_cache, inode);
+}
+
 /* Marks INODE to be deleted when it is closed by the last caller who
  * has it open. */
 void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
+	lock_acquire (&inode_table_lock);
 	inode->removed = true;
+	lock_release (&inode_table_lock);
 }
 
-/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
- * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
-off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
+/* A position within an array of buffers. */
+struct iov_cursor {
+	const struct iovec *iov;            /* Current buffer. */
+	const struct iovec *end;            /* One past the last buffer. */
+	size_t ofs;                         /* Offset within current buffer. */
+};
+
+/* Returns the total length of the CNT buffers in IOV, which the
+ * caller must ensure fits in an off_t. */
+static off_t
+iov_length (const struct iovec *iov, int cnt) {
+	off_t length = 0;
+	int i;
+
+	for (i = 0; i < cnt; i++)
+		length += iov[i].iov_len;
+	return length;
+}
+
+/* Skips past any exhausted buffers in CUR, then returns the
+ * address of CUR's position and stores the number of bytes left
+ * in its buffer in *LEFT. */
+static uint8_t *
+iov_cursor_span (struct iov_cursor *cur, size_t *left) {
+	while (cur->iov < cur->end && cur->ofs == cur->iov->iov_len) {
+		cur->iov++;
+		cur->ofs = 0;
+	}
+	ASSERT (cur->iov < cur->end);
+	*left = cur->iov->iov_len - cur->ofs;
+	return (uint8_t *) cur->iov->iov_base + cur->ofs;
+}
+
+/* Copies SIZE bytes between BUFFER and the buffers at CUR, into
+ * CUR's buffers if TO_IOV is true and out of them otherwise,
+ * and advances CUR past them. */
+static void
+iov_cursor_copy (struct iov_cursor *cur, void *buffer_, size_t size,
+		bool to_iov) {
 	uint8_t *buffer = buffer_;
+
+	while (size > 0) {
+		size_t left;
+		uint8_t *p = iov_cursor_span (cur, &left);
+		size_t n = size < left ? size : left;
+
+		if (to_iov)
+			memcpy (p, buffer, n);
+		else
+			memcpy (buffer, p, n);
+		buffer += n;
+		size -= n;
+		cur->ofs += n;
+	}
+}
+
+/* Reads SIZE bytes from INODE into the buffers at CUR, starting
+ * at position OFFSET, and advances CUR past them.  Runs of whole
+ * sectors that land inside one buffer are transferred straight
+ * into it.  The caller must hold INODE's lock.  Returns the
+ * number of bytes actually read, which may be less than SIZE if
+ * an error occurs or end of file is reached. */
+static off_t
+read_locked (struct inode *inode, struct iov_cursor *cur, off_t size,
+		off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
@@ -197,22 +413,33 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 
 		/* Number of bytes to actually copy out of this sector. */
 		int chunk_size = size < min_left ? size : min_left;
+		size_t span;
+		uint8_t *dst;
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+		dst = iov_cursor_span (cur, &span);
+		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE
+				&& span >= DISK_SECTOR_SIZE) {
+			/* Read the whole run of full sectors that fits in the
+			 * current buffer directly into it.  File data is
+			 * contiguous on disk, so one multi-sector transfer
+			 * covers it. */
+			size_t run = size < inode_left ? size : inode_left;
+			size_t sectors = (run < span ? run : span) / DISK_SECTOR_SIZE;
+			disk_read_multiple (filesys_disk, sector_idx, dst, sectors);
+			chunk_size = sectors * DISK_SECTOR_SIZE;
+			cur->ofs += chunk_size;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
+			 * into caller's buffers. */
 			if (bounce == NULL) {
 				bounce = malloc (DISK_SECTOR_SIZE);
 				if (bounce == NULL)
 					break;
 			}
 			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+			iov_cursor_copy (cur, bounce + sector_ofs, chunk_size, true);
 		}
 
 		/* Advance. */
@@ -225,20 +452,24 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	return bytes_read;
 }
 
-/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
- * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
-off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+/* Writes SIZE bytes from the buffers at CUR into INODE, starting
+ * at OFFSET, and advances CUR past them.  Runs of whole sectors
+ * that lie inside one buffer are written straight from it.  The
+ * caller must hold INODE's lock for writing and have checked
+ * that writes are allowed.  Returns the number of bytes actually
+ * written, which may be less than SIZE if end of file is reached
+ * or an error occurs. */
+static off_t
+write_locked (struct inode *inode, struct iov_cursor *cur, off_t size,
 		off_t offset) {
-	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
-		return 0;
+	/* The program loader's cached layout may no longer match. */
+	if (size > 0 && inode->exec_layout != NULL) {
+		free (inode->exec_layout);
+		inode->exec_layout = NULL;
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -252,12 +483,22 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
 		/* Number of bytes to actually write into this sector. */
 		int chunk_size = size < min_left ? size : min_left;
+		size_t span;
+		uint8_t *src;
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
+		src = iov_cursor_span (cur, &span);
+		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE
+				&& span >= DISK_SECTOR_SIZE) {
+			/* Write the whole run of full sectors that the current
+			 * buffer holds directly to disk with one multi-sector
+			 * transfer. */
+			size_t run = size < inode_left ? size : inode_left;
+			size_t sectors = (run < span ? run : span) / DISK_SECTOR_SIZE;
+			disk_write_multiple (filesys_disk, sector_idx, src, sectors);
+			chunk_size = sectors * DISK_SECTOR_SIZE;
+			cur->ofs += chunk_size;
 		} else {
 			/* We need a bounce buffer. */
 			if (bounce == NULL) {
@@ -273,7 +514,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 				disk_read (filesys_disk, sector_idx, bounce);
 			else
 				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
+			iov_cursor_copy (cur, bounce + sector_ofs, chunk_size, false);
 			disk_write (filesys_disk, sector_idx, bounce); 
 		}
 
@@ -287,13 +528,148 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	return bytes_written;
 }
 
+/* Asserts that the IOVCNT buffers in IOV are all kernel memory. */
+static void
+iov_assert_kernel (const struct iovec *iov, int iovcnt) {
+	int i;
+
+	for (i = 0; i < iovcnt; i++)
+		ASSERT (iov[i].iov_len == 0 || is_kernel_vaddr (iov[i].iov_base));
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
+ * Returns the number of bytes actually read, which may be less
+ * than SIZE if an error occurs or end of file is reached. */
+off_t
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) {
+	struct iovec iov = { buffer, size > 0 ? size : 0 };
+	return inode_readv_at (inode, &iov, 1, offset);
+}
+
+/* Reads from INODE into the IOVCNT buffers in IOV, in order,
+ * starting at position OFFSET.  The whole read is done under one
+ * acquisition of INODE's lock, so it sees a single state of the
+ * file.  Returns the number of bytes actually read, which may be
+ * less than the total length of the buffers if an error occurs
+ * or end of file is reached. */
+off_t
+inode_readv_at (struct inode *inode, const struct iovec *iov, int iovcnt,
+		off_t offset) {
+	struct iov_cursor cur = { iov, iov + iovcnt, 0 };
+	off_t bytes_read;
+
+	iov_assert_kernel (iov, iovcnt);
+	rwlock_acquire_read (&inode->rwlock);
+	bytes_read = read_locked (inode, &cur, iov_length (iov, iovcnt), offset);
+	rwlock_release_read (&inode->rwlock);
+
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+ * Returns the number of bytes actually written, which may be
+ * less than SIZE if end of file is reached or an error occurs.
+ * (Normally a write at end of file would extend the inode, but
+ * growth is not yet implemented.) */
+off_t
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
+		off_t offset) {
+	struct iovec iov = { (void *) buffer, size > 0 ? size : 0 };
+	return inode_writev_at (inode, &iov, 1, offset);
+}
+
+/* Writes the IOVCNT buffers in IOV, in order, into INODE,
+ * starting at OFFSET, under one acquisition of INODE's lock so
+ * that no other reader or writer sees part of it.  Returns the
+ * number of bytes actually written, which may be less than the
+ * total length of the buffers if end of file is reached or an
+ * error occurs. */
+off_t
+inode_writev_at (struct inode *inode, const struct iovec *iov, int iovcnt,
+		off_t offset) {
+	struct iov_cursor cur = { iov, iov + iovcnt, 0 };
+	off_t bytes_written = 0;
+
+	iov_assert_kernel (iov, iovcnt);
+	rwlock_acquire_write (&inode->rwlock);
+	if (!inode->deny_write_cnt)
+		bytes_written = write_locked (inode, &cur, iov_length (iov, iovcnt),
+				offset);
+	rwlock_release_write (&inode->rwlock);
+
+	return bytes_written;
+}
+
+/* Copies SIZE bytes from SRC, starting at SRC_OFS, into DST,
+ * starting at DST_OFS, without passing through user memory.
+ * Data is staged a page at a time in a kernel buffer; where both
+ * offsets are sector-aligned, whole sectors go from disk into
+ * the buffer and back out to disk with no copying in between.
+ * Both inodes stay locked for the whole copy, SRC for reading
+ * and DST for writing, taken in order of sector number so that
+ * two copies in opposite directions cannot deadlock.  SRC and
+ * DST may be the same inode only if the ranges do not overlap.
+ * Returns the number of bytes copied, which may be less than
+ * SIZE if end of file is reached or memory runs out. */
+off_t
+inode_copy_range (struct inode *dst, off_t dst_ofs,
+		struct inode *src, off_t src_ofs, off_t size) {
+	off_t bytes_copied = 0;
+	uint8_t *buffer;
+
+	ASSERT (src != dst || src_ofs + size <= dst_ofs
+			|| dst_ofs + size <= src_ofs);
+
+	buffer = palloc_get_page (0);
+	if (buffer == NULL)
+		return 0;
+
+	if (src == dst)
+		rwlock_acquire_write (&dst->rwlock);
+	else if (src->sector < dst->sector) {
+		rwlock_acquire_read (&src->rwlock);
+		rwlock_acquire_write (&dst->rwlock);
+	} else {
+		rwlock_acquire_write (&dst->rwlock);
+		rwlock_acquire_read (&src->rwlock);
+	}
+
+	while (!dst->deny_write_cnt && bytes_copied < size) {
+		struct iovec iov = { buffer, PGSIZE };
+		struct iov_cursor cur = { &iov, &iov + 1, 0 };
+		off_t chunk_size = size - bytes_copied;
+		off_t read, written;
+
+		if (chunk_size > PGSIZE)
+			chunk_size = PGSIZE;
+		read = read_locked (src, &cur, chunk_size, src_ofs + bytes_copied);
+		if (read == 0)
+			break;
+
+		cur.ofs = 0;
+		written = write_locked (dst, &cur, read, dst_ofs + bytes_copied);
+		bytes_copied += written;
+		if (written < read)
+			break;
+	}
+
+	if (src != dst)
+		rwlock_release_read (&src->rwlock);
+	rwlock_release_write (&dst->rwlock);
+	palloc_free_page (buffer);
+
+	return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +677,11 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->rwlock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->rwlock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -311,3 +689,19 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Returns a hash value for the sector of inode E. */
+static uint64_t
+inode_hash (const struct ohash_elem *e, void *aux UNUSED) {
+	const struct inode *inode = ohash_entry (e, struct inode, elem);
+	return hash_bytes (&inode->sector, sizeof inode->sector);
+}
+
+/* Returns true if inode A's sector precedes inode B's. */
+static bool
+inode_less (const struct ohash_elem *a_, const struct ohash_elem *b_,
+		void *aux UNUSED) {
+	const struct inode *a = ohash_entry (a_, struct inode, elem);
+	const struct inode *b = ohash_entry (b_, struct inode, elem);
+	return a->sector < b->sector;
+}
@@ -0,0 +1,323 @@
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Pipes.
+ *
+ * A pipe is a ring buffer of PIPE_SIZE bytes with a read end and
+ * a write end, each of which may be open in any number of files.
+ * The reader only ever advances `head' and the writer only ever
+ * advances `tail'.  Both are free-running and reduced modulo
+ * PIPE_SIZE.  With one reader and one writer, neither side takes
+ * a lock to move data: each copies, then publishes its new index,
+ * and the other side sees the change the next time it looks.
+ * Pintos runs on a single CPU, so an optimization barrier is
+ * enough to keep a copy and its index update in order.
+ *
+ * A side that finds the ring empty (or full) sets its `waiting'
+ * flag, looks again, and only then sleeps on its semaphore.  The
+ * other side looks at the flag after publishing its index and ups
+ * the semaphore if it is set.  One of the two always sees the
+ * other's update, so no wakeup is lost; an extra up just sends
+ * the sleeper round its loop once more.
+ *
+ * Once an end is open in more than one file, for example after
+ * fork(), its users take turns on `read_lock' or `write_lock', so
+ * that the ring still has one reader and one writer at a time.
+ * Only the holder of the sole end can duplicate it, and it cannot
+ * do so while in the middle of a read or write, so checking the
+ * count once per call is enough.
+ *
+ * Threads in poll() wait on `read_poll' or `write_poll' instead of
+ * the semaphores, since they may be waiting on other files too.
+ * Every change that could make an end ready wakes its queue,
+ * which costs a single look at the queue while no one polls. */
+
+/* Size of a pipe's ring buffer. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe. */
+struct pipe
+{
+	char *buf;					/* Ring buffer of PIPE_SIZE bytes. */
+	uint32_t head;				/* Next byte to read. */
+	uint32_t tail;				/* Next byte to write. */
+
+	bool reader_waiting;		/* Reader wants `readable' upped. */
+	bool writer_waiting;		/* Writer wants `writable' upped. */
+	struct semaphore readable;	/* Data has arrived. */
+	struct semaphore writable;	/* Room has been made. */
+	struct waitq read_poll;		/* Polling the read end. */
+	struct waitq write_poll;	/* Polling the write end. */
+
+	struct lock lock;			/* Protects `readers' and `writers'. */
+	int readers;				/* Number of open read ends. */
+	int writers;				/* Number of open write ends. */
+	struct lock read_lock;		/* Taken by readers, if several. */
+	struct lock write_lock;		/* Taken by writers, if several. */
+};
+
+/* Creates a pipe with one read end and one write end open and
+ * returns it, or returns a null pointer if memory is not
+ * available. */
+struct pipe *pipe_create(void)
+{
+	struct pipe *pipe = malloc(sizeof *pipe);
+	if (pipe == NULL)
+		return NULL;
+	pipe->buf = palloc_get_page(0);
+	if (pipe->buf == NULL)
+	{
+		free(pipe);
+		return NULL;
+	}
+
+	pipe->head = pipe->tail = 0;
+	pipe->reader_waiting = pipe->writer_waiting = false;
+	sema_init(&pipe->readable, 0);
+	sema_init(&pipe->writable, 0);
+	waitq_init(&pipe->read_poll);
+	waitq_init(&pipe->write_poll);
+	lock_init(&pipe->lock);
+	pipe->readers = pipe->writers = 1;
+	lock_init(&pipe->read_lock);
+	lock_init(&pipe->write_lock);
+	return pipe;
+}
+
+/* Opens another write end of PIPE if WRITER is true, otherwise
+ * another read end. */
+void pipe_reopen(struct pipe *pipe, bool writer)
+{
+	lock_acquire(&pipe->lock);
+	if (writer)
+		pipe->writers++;
+	else
+		pipe->readers++;
+	lock_release(&pipe->lock);
+}
+
+/* Ups SEMA if *WAITING says that someone is waiting on it. */
+static void wake(bool *waiting, struct semaphore *sema)
+{
+	barrier();
+	if (*waiting)
+	{
+		*waiting = false;
+		sema_up(sema);
+	}
+}
+
+/* Closes a write end of PIPE if WRITER is true, otherwise a read
+ * end.  Frees PIPE once both ends are fully closed. */
+void pipe_close(struct pipe *pipe, bool writer)
+{
+	bool dead;
+
+	/* Wake the other end while still holding the lock: once it
+	 * sees this end gone it may close the pipe's last end and free
+	 * it, which waits for the lock. */
+	lock_acquire(&pipe->lock);
+	if (writer)
+	{
+		pipe->writers--;
+
+		/* The reader may be waiting for end of file. */
+		wake(&pipe->reader_waiting, &pipe->readable);
+		waitq_wake(&pipe->read_poll);
+	}
+	else
+	{
+		pipe->readers--;
+
+		/* The writer may be waiting for room it will never get. */
+		wake(&pipe->writer_waiting, &pipe->writable);
+		waitq_wake(&pipe->write_poll);
+	}
+	dead = pipe->readers == 0 && pipe->writers == 0;
+	lock_release(&pipe->lock);
+
+	if (dead)
+	{
+		palloc_free_page(pipe->buf);
+		free(pipe);
+	}
+}
+
+/* Waits until PIPE has data or no write end open, and returns
+ * the number of bytes ready to read, which is 0 only at end of
+ * file. */
+static uint32_t wait_readable(struct pipe *pipe)
+{
+	for (;;)
+	{
+		/* Look at the writers first: once they are all gone,
+		 * everything they wrote is already in the ring. */
+		int writers = pipe->writers;
+		barrier();
+		uint32_t ready = pipe->tail - pipe->head;
+		if (ready > 0 || writers == 0)
+		{
+			pipe->reader_waiting = false;
+			return ready;
+		}
+
+		pipe->reader_waiting = true;
+		barrier();
+		if (pipe->tail == pipe->head && pipe->writers > 0)
+			sema_down(&pipe->readable);
+		barrier();
+	}
+}
+
+/* Waits until PIPE has room or no read end open, and returns the
+ * number of bytes that can be written, which is 0 only if no one
+ * will ever read them. */
+static uint32_t wait_writable(struct pipe *pipe)
+{
+	for (;;)
+	{
+		int readers = pipe->readers;
+		barrier();
+		uint32_t room = PIPE_SIZE - (pipe->tail - pipe->head);
+		if (room > 0 || readers == 0)
+		{
+			pipe->writer_waiting = false;
+			return readers > 0 ? room : 0;
+		}
+
+		pipe->writer_waiting = true;
+		barrier();
+		if (pipe->tail - pipe->head == PIPE_SIZE && pipe->readers > 0)
+			sema_down(&pipe->writable);
+		barrier();
+	}
+}
+
+/* Reads from PIPE into the IOVCNT buffers in IOV, in order.
+ * Waits until at least one byte is available, then reads as much
+ * as is available, up to the buffers' total length, without
+ * waiting again.  Returns the number of bytes read, which is 0
+ * at end of file, when the pipe is empty and no write end is
+ * open. */
+off_t pipe_readv(struct pipe *pipe, const struct iovec *iov, int iovcnt)
+{
+	bool shared = pipe->readers > 1;
+	off_t bytes_read = 0;
+	uint32_t ready;
+	int i;
+
+	if (shared)
+		lock_acquire(&pipe->read_lock);
+
+	ready = wait_readable(pipe);
+	for (i = 0; i < iovcnt && ready > 0; i++)
+	{
+		size_t size = iov[i].iov_len < ready ? iov[i].iov_len : ready;
+		size_t ofs = pipe->head % PIPE_SIZE;
+		size_t chunk = PIPE_SIZE - ofs < size ? PIPE_SIZE - ofs : size;
+
+		memcpy(iov[i].iov_base, pipe->buf + ofs, chunk);
+		memcpy((char *)iov[i].iov_base + chunk, pipe->buf, size - chunk);
+		barrier();
+		pipe->head += size;
+
+		bytes_read += size;
+		ready -= size;
+	}
+	if (bytes_read > 0)
+	{
+		wake(&pipe->writer_waiting, &pipe->writable);
+		waitq_wake(&pipe->write_poll);
+	}
+
+	if (shared)
+		lock_release(&pipe->read_lock);
+	return bytes_read;
+}
+
+/* Writes the IOVCNT buffers in IOV, in order, into PIPE, waiting
+ * for room as often as needed.  Returns the number of bytes
+ * written, which is less than the buffers' total length only if
+ * every read end is closed along the way, or -1 if that happens
+ * before anything is written. */
+off_t pipe_writev(struct pipe *pipe, const struct iovec *iov, int iovcnt)
+{
+	bool shared = pipe->writers > 1;
+	off_t bytes_written = 0;
+	bool broken = false;
+	int i;
+
+	if (shared)
+		lock_acquire(&pipe->write_lock);
+
+	for (i = 0; i < iovcnt && !broken; i++)
+	{
+		const char *src = iov[i].iov_base;
+		size_t left = iov[i].iov_len;
+
+		while (left > 0)
+		{
+			uint32_t room = wait_writable(pipe);
+			if (room == 0)
+			{
+				broken = true;
+				break;
+			}
+
+			size_t size = left < room ? left : room;
+			size_t ofs = pipe->tail % PIPE_SIZE;
+			size_t chunk = PIPE_SIZE - ofs < size ? PIPE_SIZE - ofs : size;
+
+			memcpy(pipe->buf + ofs, src, chunk);
+			memcpy(pipe->buf, src + chunk, size - chunk);
+			barrier();
+			pipe->tail += size;
+			wake(&pipe->reader_waiting, &pipe->readable);
+			waitq_wake(&pipe->read_poll);
+
+			src += size;
+			left -= size;
+			bytes_written += size;
+		}
+	}
+
+	if (shared)
+		lock_release(&pipe->write_lock);
+	return broken && bytes_written == 0 ? -1 : bytes_written;
+}
+
+/* Returns the poll() events that hold for PIPE's write end if
+ * WRITER is true, otherwise for its read end.  If ENTRY is not
+ * null, first adds it to that end's wait queue, so that the
+ * calling thread is woken when the answer may change. */
+short pipe_poll(struct pipe *pipe, bool writer, struct waitq_entry *entry)
+{
+	short revents = 0;
+
+	if (entry != NULL)
+		waitq_add(writer ? &pipe->write_poll : &pipe->read_poll, entry);
+	barrier();
+
+	if (writer)
+	{
+		if (pipe->readers == 0)
+			revents |= POLLERR;
+		else if (pipe->tail - pipe->head < PIPE_SIZE)
+			revents |= POLLOUT;
+	}
+	else
+	{
+		if (pipe->tail != pipe->head)
+			revents |= POLLIN;
+		if (pipe->writers == 0)
+			revents |= POLLHUP;
+	}
+	return revents;
+}
@@ -0,0 +1,22 @@
+#ifndef FILESYS_DENTRY_H
+#define FILESYS_DENTRY_H
+
+#include <stdbool.h>
+#include "devices/disk.h"
+
+/* Outcome of a dentry cache lookup. */
+enum dentry_result {
+	DENTRY_MISS,                /* Nothing cached; ask the directory. */
+	DENTRY_POSITIVE,            /* Name exists; sector is returned. */
+	DENTRY_NEGATIVE             /* Name is known not to exist. */
+};
+
+void dentry_init (void);
+enum dentry_result dentry_lookup (disk_sector_t parent, const char *name,
+		disk_sector_t *sectorp);
+void dentry_insert (disk_sector_t parent, const char *name,
+		disk_sector_t sector);
+void dentry_insert_negative (disk_sector_t parent, const char *name);
+void dentry_purge_dir (disk_sector_t parent);
+
+#endif /* filesys/dentry.h */
@@ -1,14 +1,23 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <iovec.h>
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
+struct waitq_entry;
 
 /* Opening and closing files. */
+void file_init(void);
 struct file *file_open(struct inode *);
 struct file *file_reopen(struct file *);
 struct file *file_duplicate(struct file *file);
+bool file_open_pipe(struct file **read_end, struct file **write_end);
+struct file *file_open_console(bool writer);
+struct file *file_share(struct file *);
+bool file_is_shared(struct file *);
+bool file_is_pipe(struct file *);
 void file_close(struct file *);
 struct inode *file_get_inode(struct file *);
 
@@ -17,6 +26,14 @@ off_t file_read(struct file *, void *, off_t);
 off_t file_read_at(struct file *, void *, off_t size, off_t start);
 off_t file_write(struct file *, const void *, off_t);
 off_t file_write_at(struct file *, const void *, off_t size, off_t start);
+off_t file_readv(struct file *, const struct iovec *, int iovcnt);
+off_t file_writev(struct file *, const struct iovec *, int iovcnt);
+off_t file_readv_at(struct file *, const struct iovec *, int iovcnt,
+					off_t start);
+off_t file_writev_at(struct file *, const struct iovec *, int iovcnt,
+					 off_t start);
+off_t file_copy_range(struct file *dst, struct file *src, off_t size);
+short file_poll(struct file *, struct waitq_entry *);
 
 /* Preventing writes. */
 void file_deny_write(struct file *);
@@ -2,10 +2,13 @@
 #define FILESYS_INODE_H
 
 #include <stdbool.h>
+#include <iovec.h>
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 
 struct bitmap;
+struct dir_index;
+struct exec_layout;
 
 void inode_init (void);
 bool inode_create (disk_sector_t, off_t);
@@ -16,8 +19,19 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_readv_at (struct inode *, const struct iovec *, int iovcnt,
+		off_t offset);
+off_t inode_writev_at (struct inode *, const struct iovec *, int iovcnt,
+		off_t offset);
+off_t inode_copy_range (struct inode *dst, off_t dst_ofs,
+		struct inode *src, off_t src_ofs, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+struct dir_index *inode_get_dir_index (const struct inode *);
+void inode_set_dir_index (struct inode *, struct dir_index *);
+struct exec_layout *inode_get_exec_layout (struct inode *);
+struct exec_layout *inode_set_exec_layout (struct inode *,
+		struct exec_layout *);
 
 #endif /* filesys/inode.h */
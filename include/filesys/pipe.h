@@ -0,0 +1,19 @@
+#ifndef FILESYS_PIPE_H
+#define FILESYS_PIPE_H
+
+#include <iovec.h>
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct pipe;
+struct waitq_entry;
+
+struct pipe *pipe_create(void);
+void pipe_reopen(struct pipe *, bool writer);
+void pipe_close(struct pipe *, bool writer);
+
+off_t pipe_readv(struct pipe *, const struct iovec *, int iovcnt);
+off_t pipe_writev(struct pipe *, const struct iovec *, int iovcnt);
+short pipe_poll(struct pipe *, bool writer, struct waitq_entry *);
+
+#endif /* filesys/pipe.h */
@@ -0,0 +1,95 @@
+#ifndef __LIB_IORING_H
+#define __LIB_IORING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Batched system call submission ring.
+ *
+ * A process places a struct ioring somewhere in its own memory
+ * and registers it with ioring_setup().  It then queues any
+ * number of operations, up to IORING_ENTRIES, by filling in
+ * submission entries, and hands them all to the kernel with a
+ * single ioring_enter() call.  The kernel performs them in order
+ * and posts one completion entry for each, carrying the
+ * submission's `user_data' and the value the matching system
+ * call would have returned.
+ *
+ * Both queues are indexed by free-running counters that are
+ * reduced modulo IORING_ENTRIES.  The process advances sq_tail
+ * and cq_head; the kernel advances sq_head and cq_tail.  The
+ * kernel only looks at the ring inside ioring_enter(), so no
+ * memory barriers are needed. */
+
+/* Number of entries in each queue.  Must be a power of 2. */
+#define IORING_ENTRIES 64
+
+/* Operations. */
+enum {
+	IORING_OP_NOP,              /* Do nothing; result is 0. */
+	IORING_OP_READ,             /* read(), or pread() if off >= 0. */
+	IORING_OP_WRITE,            /* write(), or pwrite() if off >= 0. */
+	IORING_OP_OPEN,             /* open() of file name at addr. */
+	IORING_OP_CLOSE,            /* close(). */
+	IORING_OP_MMAP,             /* mmap(); flags != 0 if writable. */
+};
+
+/* Submission queue entry. */
+struct ioring_sqe {
+	uint32_t opcode;            /* IORING_OP_*. */
+	int32_t fd;                 /* File descriptor. */
+	uint64_t addr;              /* Buffer, file name or map address. */
+	uint32_t len;               /* Buffer or mapping length. */
+	uint32_t flags;             /* Operation-specific flags. */
+	int64_t off;                /* File offset, or -1 for the
+	                               current position. */
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* Completion queue entry. */
+struct ioring_cqe {
+	uint64_t user_data;         /* From the submission. */
+	int64_t res;                /* Result of the operation. */
+};
+
+/* Submission and completion ring. */
+struct ioring {
+	uint32_t sq_head;           /* Next submission to perform. */
+	uint32_t sq_tail;           /* Next free submission entry. */
+	uint32_t cq_head;           /* Next completion to consume. */
+	uint32_t cq_tail;           /* Next free completion entry. */
+	struct ioring_sqe sqes[IORING_ENTRIES];
+	struct ioring_cqe cqes[IORING_ENTRIES];
+};
+
+/* Returns a cleared submission entry at the tail of RING's
+   submission queue, or a null pointer if the queue is full.
+   The entry is queued at once; fill it in before the next call
+   to ioring_enter(). */
+static inline struct ioring_sqe *
+ioring_get_sqe (struct ioring *ring) {
+	struct ioring_sqe *sqe;
+
+	if (ring->sq_tail - ring->sq_head >= IORING_ENTRIES)
+		return NULL;
+	sqe = &ring->sqes[ring->sq_tail++ % IORING_ENTRIES];
+	*sqe = (struct ioring_sqe) { .off = -1 };
+	return sqe;
+}
+
+/* Returns the oldest unconsumed completion in RING, or a null
+   pointer if there is none. */
+static inline struct ioring_cqe *
+ioring_peek_cqe (struct ioring *ring) {
+	if (ring->cq_head == ring->cq_tail)
+		return NULL;
+	return &ring->cqes[ring->cq_head % IORING_ENTRIES];
+}
+
+/* Consumes the completion returned by ioring_peek_cqe(). */
+static inline void
+ioring_cqe_seen (struct ioring *ring) {
+	ring->cq_head++;
+}
+
+#endif /* lib/ioring.h */
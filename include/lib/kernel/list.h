@@ -160,4 +160,27 @@ void list_unique (struct list *, struct list *duplicates,
 struct list_elem *list_max (struct list *, list_less_func *, void *aux);
 struct list_elem *list_min (struct list *, list_less_func *, void *aux);
 
+/* Counted list.
+ *
+ * A list that also keeps its number of elements, so that
+ * clist_size() runs in constant time instead of walking the
+ * list.  Elements must be added and removed only through the
+ * clist_* functions below; everything else, such as traversal,
+ * works on the embedded `list' as usual. */
+struct clist {
+	struct list list;           /* The underlying list. */
+	size_t size;                /* Number of elements in `list'. */
+};
+
+void clist_init (struct clist *);
+void clist_push_front (struct clist *, struct list_elem *);
+void clist_push_back (struct clist *, struct list_elem *);
+void clist_insert_ordered (struct clist *, struct list_elem *,
+                           list_less_func *, void *aux);
+struct list_elem *clist_remove (struct clist *, struct list_elem *);
+struct list_elem *clist_pop_front (struct clist *);
+struct list_elem *clist_pop_back (struct clist *);
+size_t clist_size (struct clist *);
+bool clist_empty (struct clist *);
+
 #endif /* lib/kernel/list.h */
@@ -0,0 +1,110 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+ *
+ * A drop-in alternative to the chained hash table in hash.h,
+ * with the same interface under an `ohash_' prefix.  Instead of
+ * an array of lists, the table is a single array of pointers to
+ * elements, searched by linear probing with Robin Hood
+ * insertion, so a lookup touches one or two cache lines of the
+ * array plus the elements it compares against.  Each element
+ * remembers its own hash value, which is compared before calling
+ * the comparison function.
+ *
+ * When the table grows, elements are not all moved at once.
+ * A new array twice the size is allocated and later insertions
+ * and deletions each move a few elements over from the old one,
+ * so no single operation pays for rehashing the whole table.
+ * Lookups search both arrays while this is going on.
+ *
+ * Like the other containers in lib/kernel, the table does not
+ * allocate its elements.  Each structure that can be in a table
+ * embeds a struct ohash_elem member, and ohash_entry() converts
+ * a struct ohash_elem back to the structure that contains it.
+ * Refer to lib/kernel/list.h for a detailed explanation of the
+ * technique.  The sample hash functions in hash.h work for this
+ * table too. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hash element. */
+struct ohash_elem {
+	uint64_t hash;              /* Hash value, set on insertion. */
+};
+
+/* Converts pointer to hash element OHASH_ELEM into a pointer to
+   the structure that OHASH_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the hash element. */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)         \
+	((STRUCT *) ((uint8_t *) &(OHASH_ELEM)->hash    \
+		- offsetof (STRUCT, MEMBER.hash)))
+
+/* Computes and returns the hash value for hash element E, given
+   auxiliary data AUX. */
+typedef uint64_t ohash_hash_func (const struct ohash_elem *e, void *aux);
+
+/* Compares the value of two hash elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool ohash_less_func (const struct ohash_elem *a,
+                              const struct ohash_elem *b,
+                              void *aux);
+
+/* Performs some operation on hash element E, given auxiliary
+   data AUX. */
+typedef void ohash_action_func (struct ohash_elem *e, void *aux);
+
+/* One array of slots. */
+struct ohash_table {
+	struct ohash_elem **slots;  /* Array of `mask + 1' slots. */
+	size_t mask;                /* Number of slots minus 1. */
+	size_t elem_cnt;            /* Number of occupied slots. */
+};
+
+/* Hash table. */
+struct ohash {
+	size_t elem_cnt;            /* Number of elements in table. */
+	struct ohash_table cur;     /* Where new elements go. */
+	struct ohash_table old;     /* Being emptied into `cur', if
+	                               `old.slots' is non-null. */
+	size_t old_pos;             /* Next slot of `old' to move. */
+	ohash_hash_func *hash;      /* Hash function. */
+	ohash_less_func *less;      /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `hash' and `less'. */
+};
+
+/* A hash table iterator. */
+struct ohash_iterator {
+	struct ohash *hash;         /* The hash table. */
+	struct ohash_table *table;  /* Array being visited. */
+	size_t idx;                 /* Index of next slot to visit. */
+	struct ohash_elem *elem;    /* Current hash element. */
+};
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, ohash_hash_func *, ohash_less_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+
+/* Search, insertion, deletion. */
+struct ohash_elem *ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_replace (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct ohash_elem *ohash_next (struct ohash_iterator *);
+struct ohash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -0,0 +1,73 @@
+#ifndef __LIB_KERNEL_PHEAP_H
+#define __LIB_KERNEL_PHEAP_H
+
+/* Pairing heap.
+ *
+ * A priority queue with O(1) insertion and access to the
+ * minimum, and O(lg n) amortized removal of the minimum or of an
+ * arbitrary element.  It suits queues that are mostly pushed and
+ * popped in priority order, such as timers and wait queues, and
+ * is cheaper than a red-black tree when the elements in between
+ * never need to be visited in order.
+ *
+ * Like lists and hash tables, the heap does not allocate memory.
+ * Each structure that can be in a heap embeds a struct
+ * pheap_elem member, and pheap_entry() converts a struct
+ * pheap_elem back to the structure that contains it.  Refer to
+ * lib/kernel/list.h for a detailed explanation of the
+ * technique.
+ *
+ * The heap is not stable: equal elements may come out in any
+ * order.  Break ties in the comparison function, for example on
+ * an insertion sequence number, if that matters. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct pheap_elem {
+	struct pheap_elem *child;   /* First child, or null. */
+	struct pheap_elem *next;    /* Next sibling, or null. */
+	struct pheap_elem *prev;    /* Previous sibling, or parent if
+	                               first child, or null if root. */
+};
+
+/* Converts pointer to heap element PHEAP_ELEM into a pointer to
+   the structure that PHEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define pheap_entry(PHEAP_ELEM, STRUCT, MEMBER)         \
+	((STRUCT *) ((uint8_t *) &(PHEAP_ELEM)->child   \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B.  The heap hands out
+   the least element first. */
+typedef bool pheap_less_func (const struct pheap_elem *a,
+                              const struct pheap_elem *b,
+                              void *aux);
+
+/* Pairing heap. */
+struct pheap {
+	struct pheap_elem *root;    /* Least element, or null if empty. */
+	size_t elem_cnt;            /* Number of elements in heap. */
+	pheap_less_func *less;      /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void pheap_init (struct pheap *, pheap_less_func *, void *aux);
+
+/* Insertion and deletion. */
+void pheap_push (struct pheap *, struct pheap_elem *);
+struct pheap_elem *pheap_pop (struct pheap *);
+void pheap_remove (struct pheap *, struct pheap_elem *);
+void pheap_decrease (struct pheap *, struct pheap_elem *);
+
+/* Information. */
+struct pheap_elem *pheap_min (struct pheap *);
+size_t pheap_size (struct pheap *);
+bool pheap_empty (struct pheap *);
+
+#endif /* lib/kernel/pheap.h */
@@ -0,0 +1,24 @@
+#ifndef __LIB_POLL_H
+#define __LIB_POLL_H
+
+/* One file descriptor to watch in a poll() call.  The caller sets
+   `fd' and `events'; poll() sets `revents' to those of `events'
+   that hold, plus POLLERR, POLLHUP and POLLNVAL whenever they do.
+   An entry with a negative `fd' is skipped and gets no events. */
+struct pollfd {
+	int fd;                     /* File descriptor. */
+	short events;               /* Events to wait for. */
+	short revents;              /* Events that happened. */
+};
+
+/* Events. */
+#define POLLIN   0x001          /* Reading would not wait. */
+#define POLLOUT  0x004          /* Writing would not wait. */
+#define POLLERR  0x008          /* Pipe has no read end left. */
+#define POLLHUP  0x010          /* Pipe has no write end left. */
+#define POLLNVAL 0x020          /* `fd' is not open. */
+
+/* Maximum number of entries in one poll() call. */
+#define POLL_MAX 64
+
+#endif /* lib/poll.h */
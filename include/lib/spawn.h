@@ -0,0 +1,17 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* A file that a process started by spawn() inherits.  The new
+   process starts with only the console, as fds 0 and 1, and,
+   for each of these passed to spawn(), a duplicate of the
+   parent's file `fd' as its own file `newfd'.  A `newfd' of 0
+   or 1 takes the place of the console. */
+struct spawn_fd {
+	int fd;                     /* Parent's file descriptor. */
+	int newfd;                  /* Child's file descriptor. */
+};
+
+/* Maximum number of files inherited through one spawn() call. */
+#define SPAWN_FD_MAX 16
+
+#endif /* lib/spawn.h */
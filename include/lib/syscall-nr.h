@@ -36,6 +36,31 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Vectored and positional I/O. */
+	SYS_READV,                  /* Read from a file into several buffers. */
+	SYS_WRITEV,                 /* Write several buffers to a file. */
+	SYS_PREAD,                  /* Read from a file at a given position. */
+	SYS_PWRITE,                 /* Write to a file at a given position. */
+
+	/* In-kernel copying. */
+	SYS_COPY_FILE_RANGE,        /* Copy data from one file to another. */
+	SYS_SENDFILE,               /* Copy data from a file to a file or
+	                               the console. */
+
+	/* Process creation without copying. */
+	SYS_VFORK,                  /* Create a child that borrows the
+	                               address space until exec. */
+	SYS_SPAWN,                  /* Start a program in a new process. */
+
+	/* Interprocess communication. */
+	SYS_PIPE,                   /* Create a pipe. */
+	SYS_POLL,                   /* Wait for file descriptors to be
+	                               ready. */
+
+	/* Batched submission. */
+	SYS_IORING_SETUP,           /* Register a submission ring. */
+	SYS_IORING_ENTER,           /* Perform queued submissions. */
 };
 
 #endif /* lib/syscall-nr.h */
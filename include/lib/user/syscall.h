@@ -4,6 +4,10 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <iovec.h>
+#include <poll.h>
+#include <ioring.h>
+#include <spawn.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -24,6 +28,9 @@ typedef int off_t;
 void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
 pid_t fork (const char *thread_name);
+pid_t vfork (void);
+pid_t spawn (const char *file, char *const argv[], const struct spawn_fd *fds,
+             int fd_cnt);
 int exec (const char *file);
 int wait (pid_t);
 bool create (const char *file, unsigned initial_size);
@@ -32,11 +39,21 @@ int open (const char *file);
 int filesize (int fd);
 int read (int fd, void *buffer, unsigned length);
 int write (int fd, const void *buffer, unsigned length);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int copy_file_range (int fd_in, int fd_out, unsigned length);
+int sendfile (int fd_out, int fd_in, unsigned length);
+int ioring_setup (struct ioring *ring);
+int ioring_enter (unsigned to_submit);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 
 int dup2(int oldfd, int newfd);
+int pipe (int fds[2]);
+int poll (struct pollfd *fds, unsigned nfds, int timeout);
 
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
@@ -41,6 +41,47 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
+/* Readers-writer lock. */
+struct rwlock
+{
+	struct lock lock;			 /* Protects the members below. */
+	struct condition readers_ok; /* Signaled when readers may enter. */
+	struct condition writer_ok;	 /* Signaled when a writer may enter. */
+	int readers;				 /* Number of readers holding the lock. */
+	int writers_waiting;		 /* Number of writers waiting for it. */
+	bool writer;				 /* True if a writer holds the lock. */
+};
+
+void rwlock_init(struct rwlock *);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+
+/* Wait queue.
+ *
+ * The threads polling an object, such as one end of a pipe, for a
+ * change in its readiness.  Each poller adds an entry of its own
+ * and removes it when done.  Unlike the primitives above, a wait
+ * queue can be woken from an interrupt handler. */
+struct waitq
+{
+	struct list entries; /* List of struct waitq_entry. */
+};
+
+/* One thread's entry in a wait queue. */
+struct waitq_entry
+{
+	struct list_elem elem; /* Element in the queue's `entries'. */
+	struct thread *thread; /* Thread to wake. */
+	struct waitq *queue;   /* Queue it is in, or null. */
+};
+
+void waitq_init(struct waitq *);
+void waitq_add(struct waitq *, struct waitq_entry *);
+void waitq_remove(struct waitq_entry *);
+void waitq_wake(struct waitq *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
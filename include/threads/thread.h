@@ -25,6 +25,10 @@ enum thread_status
 typedef int tid_t;
 #define TID_ERROR ((tid_t)-1) /* Error value for tid_t. */
 
+/* File descriptors kept inside struct thread before the table
+   has to grow. */
+#define FD_INLINE 16
+
 /* Thread priorities. */
 #define PRI_MIN 0	   /* Lowest priority. */
 #define PRI_DEFAULT 31 /* Default priority. */
@@ -96,6 +100,8 @@ struct thread
 	int priority;			   /* Priority. */
 
 	int64_t wakeup_tick; /* tick till wake up */
+	bool event_waiting;  /* Blocked in thread_wait_event(). */
+	bool event_timed;    /* ...and in sleep_list until wakeup_tick. */
 
 	/* for priority donation */
 	int origin_priority;
@@ -113,8 +119,17 @@ struct thread
 
 	/* project 2 user program */
 	int exit_status;
+	/* File descriptor table.  Starts out as the FD_INLINE slots
+	 * below and is moved to a malloc()'d array of twice the size
+	 * whenever it fills up, up to FD_MAX.  fd_map has one bit per
+	 * slot, set if the fd is in use.  A process starts with the
+	 * console's input and output ends as fds 0 and 1. */
 	struct file **fd_table;
-	int fd_idx;
+	uint64_t *fd_map;
+	int fd_cap;	 /* Number of slots in fd_table. */
+	int fd_cnt;	 /* Number of bits set in fd_map. */
+	struct file *fd_inline[FD_INLINE];
+	uint64_t fd_inline_map;
 
 	/* for fork() */
 	struct intr_frame parent_if;
@@ -125,6 +140,12 @@ struct thread
 	struct semaphore wait_sema;
 	struct semaphore free_sema;
 	struct file *running;
+	/* Submission ring registered with ioring_setup(), in user
+	 * memory, or null. */
+	struct ioring *ioring;
+	/* Parent whose address space this process is borrowing, from
+	 * vfork() until it execs or exits, or null. */
+	struct thread *vfork_parent;
 	// int stdin_count;
 	// int stdout_count;
 
@@ -181,6 +202,8 @@ void do_iret(struct intr_frame *tf);
 #endif /* threads/thread.h */
 
 void thread_sleep(int64_t);
+void thread_wait_event(int64_t wakeup_tick);
+void thread_wake_event(struct thread *);
 void update_next_tick_to_awake();
 struct list sleep_list;
 int64_t next_tick_to_awake;
@@ -0,0 +1,9 @@
+#ifndef USERPROG_IORING_H
+#define USERPROG_IORING_H
+
+#include <ioring.h>
+
+int ioring_setup(struct ioring *ring);
+int ioring_enter(unsigned to_submit);
+
+#endif /* userprog/ioring.h */
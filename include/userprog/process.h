@@ -1,18 +1,24 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <spawn.h>
 #include "threads/thread.h"
 
 tid_t process_create_initd(const char *file_name);
 tid_t process_fork(const char *name, struct intr_frame *if_);
+tid_t process_vfork(const char *name, struct intr_frame *if_);
+tid_t process_spawn(char *page, const char *args, size_t size, int argc,
+					const struct spawn_fd *fds, int fd_cnt);
 int process_exec(void *f_name);
 int process_wait(tid_t);
 void process_exit(void);
 void process_activate(struct thread *next);
 
-void argument_stack(char **argv, int argc, void **rsp);
+bool argument_stack(const char *args, size_t size, int argc,
+					struct intr_frame *if_);
 struct file *process_get_file(int fd);
 int process_add_file(struct file *f);
 void process_close_file(int fd);
+int process_dup2(int oldfd, int newfd);
 
 #endif /* userprog/process.h */
\ No newline at end of file
@@ -1,11 +1,12 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <iovec.h>
+#include <poll.h>
+#include <spawn.h>
 #include "threads/synch.h"
 #include "threads/thread.h"
 
-struct lock filesys_lock;
-
 void syscall_init(void);
 
 void halt(void);
@@ -14,18 +15,29 @@ int open(const char *file);
 int filesize(int fd);
 int read(int fd, void *buffer, unsigned size);
 int write(int fd, const void *buffer, unsigned size);
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
+int pread(int fd, void *buffer, unsigned size, off_t offset);
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset);
+int copy_file_range(int fd_in, int fd_out, unsigned length);
+int sendfile(int fd_out, int fd_in, unsigned length);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
+int dup2(int oldfd, int newfd);
+int pipe(int *fds);
+int poll(struct pollfd *fds, unsigned nfds, int timeout);
 
 int exec(char *file_name);
 tid_t fork(const char *thread_name, struct intr_frame *f);
+tid_t vfork(struct intr_frame *f);
+tid_t spawn(const char *file, char *const argv[],
+			const struct spawn_fd *fds, int fd_cnt);
 int wait(tid_t pid);
 
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
 
-void check_address(void *addr);
 struct page *check_address2(void *addr);
 
 #endif /* userprog/syscall.h */
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* Returns true if the SIZE bytes starting at UADDR all lie below
+ * KERN_BASE.  Says nothing about whether they are mapped. */
+static inline bool is_user_range(const void *uaddr, size_t size)
+{
+	uintptr_t start = (uintptr_t)uaddr;
+	return start + size >= start && start + size <= KERN_BASE;
+}
+
+bool copy_from_user(void *dst, const void *usrc, size_t size);
+bool copy_to_user(void *udst, const void *src, size_t size);
+int strncpy_from_user(char *dst, const char *usrc, size_t size);
+
+bool uaccess_fixup(struct intr_frame *f);
+
+#endif /* userprog/uaccess.h */
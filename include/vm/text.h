@@ -0,0 +1,21 @@
+#ifndef VM_TEXT_H
+#define VM_TEXT_H
+#include "vm/vm.h"
+
+struct page;
+enum vm_type;
+struct text_frame;
+
+/* A page of an executable's read-only text, mapped onto a frame
+ * that is shared with every other process mapping the same page
+ * of the same executable. */
+struct text_page
+{
+	struct text_frame *shared; /* Shared frame. */
+};
+
+void vm_text_init(void);
+bool text_initializer(struct page *page, enum vm_type type, void *kva);
+bool vm_text_claim(struct page *page);
+bool vm_text_copy(struct page *src);
+#endif
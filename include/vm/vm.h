@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/ohash.h"
 
 enum vm_type
 {
@@ -14,6 +15,8 @@ enum vm_type
 	VM_FILE = 2,
 	/* page that hold the page cache, for project 4 */
 	VM_PAGE_CACHE = 3,
+	/* read-only executable page, shared between processes */
+	VM_TEXT = 4,
 
 	/* Bit flags to store state */
 
@@ -29,6 +32,7 @@ enum vm_type
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/text.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
@@ -49,7 +53,7 @@ struct page
 	struct frame *frame; /* Back reference for frame */
 
 	/* Your implementation */
-	struct hash_elem hash_elem; /* Hash table element. */
+	struct ohash_elem hash_elem; /* Hash table element. */
 	bool write;
 
 	/* Per-type data are binded into the union.
@@ -59,6 +63,7 @@ struct page
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
+		struct text_page text;
 #ifdef EFILESYS
 		struct page_cache page_cache;
 #endif
@@ -95,7 +100,7 @@ struct page_operations
  * All designs up to you for this. */
 struct supplemental_page_table
 {
-	struct hash pages;
+	struct ohash pages;
 };
 
 #include "threads/thread.h"
@@ -120,9 +125,9 @@ void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
 enum vm_type page_get_type(struct page *page);
 
-unsigned page_hash(const struct hash_elem *p_, void *aux UNUSED);
-bool page_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
-void hash_action_destroy(struct hash_elem *hash_elem_, void *aux);
+uint64_t page_hash(const struct ohash_elem *p_, void *aux UNUSED);
+bool page_less(const struct ohash_elem *a_, const struct ohash_elem *b_, void *aux UNUSED);
+void hash_action_destroy(struct ohash_elem *hash_elem_, void *aux);
 
 struct aux_val
 {
@@ -132,6 +137,9 @@ struct aux_val
 	off_t offset;
 };
 
+struct aux_val *aux_val_alloc(void);
+void aux_val_free(struct aux_val *aux);
+
 struct swap_table
 {
 }
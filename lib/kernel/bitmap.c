@@ -23,10 +23,17 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   A second, much smaller array summarizes the first, with one
+   bit per element that is set exactly when every bit of that
+   element is set.  Scans for false bits consult the summary to
+   skip ELEM_BITS full elements at a time, which matters for large,
+   mostly allocated bitmaps such as the free map of a big disk. */
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	elem_type *full;    /* Summary: one bit per element of BITS. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -55,6 +62,13 @@ byte_cnt (size_t bit_cnt) {
 	return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns the number of bytes required for BIT_CNT bits plus
+   their summary. */
+static inline size_t
+storage_cnt (size_t bit_cnt) {
+	return byte_cnt (bit_cnt) + byte_cnt (elem_cnt (bit_cnt));
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -62,6 +76,48 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns element IDX of B with the bits that are set to VALUE
+   turned on and all others, including any past the end of B,
+   turned off. */
+static inline elem_type
+match_elem (const struct bitmap *b, size_t idx, bool value) {
+	elem_type e = b->bits[idx];
+
+	if (!value)
+		e = ~e;
+	if (idx == elem_cnt (b->bit_cnt) - 1)
+		e &= last_mask (b);
+	return e;
+}
+
+/* Brings the summary bit for element IDX of B up to date.
+
+   Bits are set and cleared atomically, but a summary bit is
+   updated separately from its element, so another thread may
+   change the element in between.  Checking afterward that the
+   element still holds the value the summary was derived from,
+   and retrying if not, ensures that the last thread to write the
+   summary bit wrote the right value. */
+static void
+update_summary (struct bitmap *b, size_t idx) {
+	const volatile elem_type *elem = &b->bits[idx];
+	elem_type used = idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b)
+		: (elem_type) -1;
+	size_t sum_idx = elem_idx (idx);
+	elem_type sum_mask = bit_mask (idx);
+	elem_type e;
+
+	do {
+		e = *elem;
+		if ((~e & used) == 0)
+			asm ("lock orq %1, %0" : "+m" (b->full[sum_idx])
+					: "r" (sum_mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "+m" (b->full[sum_idx])
+					: "r" (~sum_mask) : "cc");
+	} while (*elem != e);
+}
 
 /* Creation and destruction. */
 
@@ -74,8 +130,9 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
-		b->bits = malloc (byte_cnt (bit_cnt));
+		b->bits = malloc (storage_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
+			b->full = b->bits + elem_cnt (bit_cnt);
 			bitmap_set_all (b, false);
 			return b;
 		}
@@ -95,6 +152,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 
 	b->bit_cnt = bit_cnt;
 	b->bits = (elem_type *) (b + 1);
+	b->full = b->bits + elem_cnt (bit_cnt);
 	bitmap_set_all (b, false);
 	return b;
 }
@@ -103,7 +161,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
    with BIT_CNT bits (for use with bitmap_create_in_buf()). */
 size_t
 bitmap_buf_size (size_t bit_cnt) {
-	return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+	return sizeof (struct bitmap) + storage_cnt (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -148,6 +206,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the OR instruction in [IA32-v2b]. */
 	asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -160,6 +219,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +234,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -194,17 +255,31 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, but not the group as a
+   whole. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	while (cnt > 0) {
+		size_t idx = elem_idx (start);
+		size_t ofs = start % ELEM_BITS;
+		size_t n = ELEM_BITS - ofs < cnt ? ELEM_BITS - ofs : cnt;
+		elem_type mask = (n < ELEM_BITS ? ((elem_type) 1 << n) - 1
+				: (elem_type) -1) << ofs;
+
+		if (value)
+			asm ("lock orq %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "+m" (b->bits[idx]) : "r" (~mask) : "cc");
+		update_summary (b, idx);
+
+		start += n;
+		cnt -= n;
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -263,23 +338,93 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 
 /* Finding set or unset bits. */
 
+/* Returns the index of the first element of B at or after IDX
+   that has any bit set to VALUE, or the number of elements if
+   there is none.  Uses the summary to skip full elements when
+   looking for false bits. */
+static size_t
+next_match_elem (const struct bitmap *b, size_t idx, bool value) {
+	size_t elems = elem_cnt (b->bit_cnt);
+
+	if (value) {
+		while (idx < elems && match_elem (b, idx, true) == 0)
+			idx++;
+		return idx;
+	}
+
+	while (idx < elems) {
+		elem_type not_full = ~b->full[elem_idx (idx)] >> (idx % ELEM_BITS);
+		if (not_full != 0) {
+			idx += __builtin_ctzl (not_full);
+			break;
+		}
+		idx = ROUND_UP (idx + 1, ELEM_BITS);
+	}
+	return idx < elems ? idx : elems;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Works an element at a time: runs of matching bits are measured
+   with a count-trailing-zeros instruction, and elements with no
+   matching bit at all are skipped outright. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
+	size_t run_start = start;   /* Start of the current run. */
+	size_t i = start;           /* First bit not yet examined. */
+
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
+	if (cnt > b->bit_cnt)
+		return BITMAP_ERROR;
+	if (cnt == 0)
+		return start;
+
+	while (i < b->bit_cnt) {
+		size_t ofs = i % ELEM_BITS;
+		size_t avail = ELEM_BITS - ofs;
+		elem_type e;
+
+		/* Between runs, skip elements with nothing to offer. */
+		if (i == run_start && ofs == 0) {
+			i = next_match_elem (b, elem_idx (i), value) * ELEM_BITS;
+			run_start = i;
+			if (i >= b->bit_cnt)
+				break;
+		}
+
+		e = match_elem (b, elem_idx (i), value) >> ofs;
+		if (avail == ELEM_BITS ? e == (elem_type) -1
+				: e == ((elem_type) 1 << avail) - 1) {
+			/* The run continues through the end of the element. */
+			i += avail;
+		} else {
+			/* The run ends inside this element.  Find where the
+			   next one begins, if it begins in this element. */
+			size_t ones = __builtin_ctzl (~e);
+			if (i + ones - run_start >= cnt)
+				return run_start;
+			e >>= ones;
+			if (e == 0) {
+				i += avail;
+				run_start = i;
+				continue;
+			}
+			i += ones + __builtin_ctzl (e);
+			run_start = i;
+		}
+		if (i - run_start >= cnt)
+			return run_start;
 	}
-	return BITMAP_ERROR;
+
+	if (i > b->bit_cnt)
+		i = b->bit_cnt;
+	return i - run_start >= cnt && run_start < b->bit_cnt ? run_start
+		: BITMAP_ERROR;
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -313,8 +458,12 @@ bitmap_read (struct bitmap *b, struct file *file) {
 	bool success = true;
 	if (b->bit_cnt > 0) {
 		off_t size = byte_cnt (b->bit_cnt);
+		size_t idx;
+
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		for (idx = 0; idx < elem_cnt (b->bit_cnt); idx++)
+			update_summary (b, idx);
 	}
 	return success;
 }
@@ -32,7 +32,7 @@
    operations, which can be valuable.) */
 
 static bool is_sorted (struct list_elem *a, struct list_elem *b,
-		list_less_func *less, void *aux) UNUSED;
+		list_less_func *less, void *aux);
 
 /* Returns true if ELEM is a head, false otherwise. */
 static inline bool
@@ -330,91 +330,103 @@ is_sorted (struct list_elem *a, struct list_elem *b,
 	return true;
 }
 
-/* Finds a run, starting at A and ending not after B, of list
-   elements that are in nondecreasing order according to LESS
-   given auxiliary data AUX.  Returns the (exclusive) end of the
-   run.
-   A through B (exclusive) must form a non-empty range. */
+/* Merges A and B, two null-terminated chains of elements linked
+   through their `next' members and each sorted in nondecreasing
+   order according to LESS given auxiliary data AUX, into a
+   single sorted chain, which is returned.  Elements of A come
+   before equal elements of B.  `prev' members are not touched. */
 static struct list_elem *
-find_end_of_run (struct list_elem *a, struct list_elem *b,
+merge_chains (struct list_elem *a, struct list_elem *b,
 		list_less_func *less, void *aux) {
-	ASSERT (a != NULL);
-	ASSERT (b != NULL);
-	ASSERT (less != NULL);
-	ASSERT (a != b);
-
-	do {
-		a = list_next (a);
-	} while (a != b && !less (a, list_prev (a), aux));
-	return a;
-}
-
-/* Merges A0 through A1B0 (exclusive) with A1B0 through B1
-   (exclusive) to form a combined range also ending at B1
-   (exclusive).  Both input ranges must be nonempty and sorted in
-   nondecreasing order according to LESS given auxiliary data
-   AUX.  The output range will be sorted the same way. */
-static void
-inplace_merge (struct list_elem *a0, struct list_elem *a1b0,
-		struct list_elem *b1,
-		list_less_func *less, void *aux) {
-	ASSERT (a0 != NULL);
-	ASSERT (a1b0 != NULL);
-	ASSERT (b1 != NULL);
-	ASSERT (less != NULL);
-	ASSERT (is_sorted (a0, a1b0, less, aux));
-	ASSERT (is_sorted (a1b0, b1, less, aux));
-
-	while (a0 != a1b0 && a1b0 != b1)
-		if (!less (a1b0, a0, aux))
-			a0 = list_next (a0);
-		else {
-			a1b0 = list_next (a1b0);
-			list_splice (a0, list_prev (a1b0), a1b0);
+	struct list_elem *head = NULL;
+	struct list_elem **tail = &head;
+
+	while (a != NULL && b != NULL) {
+		if (less (b, a, aux)) {
+			*tail = b;
+			b = b->next;
+		} else {
+			*tail = a;
+			a = a->next;
 		}
+		tail = &(*tail)->next;
+	}
+	*tail = a != NULL ? a : b;
+	return head;
 }
 
+/* Maximum number of pending chains in list_sort().  Chain I
+   holds 2**I elements, so this is enough for any list that fits
+   in memory. */
+#define SORT_LEVELS 48
+
 /* Sorts LIST according to LESS given auxiliary data AUX, using a
-   natural iterative merge sort that runs in O(n lg n) time and
-   O(1) space in the number of elements in LIST. */
+   stable bottom-up merge sort that runs in O(n lg n) time and
+   O(lg n) space in the number of elements in LIST.
+
+   The list is first checked for being sorted already, which is
+   the common case for wait queues that are re-sorted after every
+   priority change.  Otherwise, elements are taken off the front
+   one at a time and merged into a binary counter of sorted
+   chains, so that each element is merged about lg n times with
+   neighbors it was merged with recently, instead of the whole
+   list being walked on every pass.  The `prev' links are rebuilt
+   in a single pass at the end. */
 void
 list_sort (struct list *list, list_less_func *less, void *aux) {
-	size_t output_run_cnt;        /* Number of runs output in current pass. */
+	struct list_elem *pending[SORT_LEVELS];
+	size_t level_cnt = 0;
+	struct list_elem *e, *next, *prev;
+	size_t i;
 
 	ASSERT (list != NULL);
 	ASSERT (less != NULL);
 
-	/* Pass over the list repeatedly, merging adjacent runs of
-	   nondecreasing elements, until only one run is left. */
-	do {
-		struct list_elem *a0;     /* Start of first run. */
-		struct list_elem *a1b0;   /* End of first run, start of second. */
-		struct list_elem *b1;     /* End of second run. */
-
-		output_run_cnt = 0;
-		for (a0 = list_begin (list); a0 != list_end (list); a0 = b1) {
-			/* Each iteration produces one output run. */
-			output_run_cnt++;
-
-			/* Locate two adjacent runs of nondecreasing elements
-			   A0...A1B0 and A1B0...B1. */
-			a1b0 = find_end_of_run (a0, list_end (list), less, aux);
-			if (a1b0 == list_end (list))
-				break;
-			b1 = find_end_of_run (a1b0, list_end (list), less, aux);
-
-			/* Merge the runs. */
-			inplace_merge (a0, a1b0, b1, less, aux);
+	if (is_sorted (list_begin (list), list_end (list), less, aux))
+		return;
+
+	/* Turn LIST into a null-terminated chain. */
+	list_back (list)->next = NULL;
+
+	for (e = list_begin (list); e != NULL; e = next) {
+		struct list_elem *carry = e;
+
+		next = e->next;
+		e->next = NULL;
+		for (i = 0; i < level_cnt && pending[i] != NULL; i++) {
+			carry = merge_chains (pending[i], carry, less, aux);
+			pending[i] = NULL;
 		}
+		ASSERT (i < SORT_LEVELS);
+		pending[i] = carry;
+		if (i == level_cnt)
+			level_cnt++;
+	}
+
+	/* Higher levels hold earlier elements. */
+	e = NULL;
+	for (i = 0; i < level_cnt; i++)
+		if (pending[i] != NULL)
+			e = merge_chains (pending[i], e, less, aux);
+
+	/* Relink the sorted chain into LIST. */
+	prev = list_head (list);
+	for (; e != NULL; e = e->next) {
+		prev->next = e;
+		e->prev = prev;
+		prev = e;
 	}
-	while (output_run_cnt > 1);
+	prev->next = list_tail (list);
+	list_tail (list)->prev = prev;
 
 	ASSERT (is_sorted (list_begin (list), list_end (list), less, aux));
 }
 
 /* Inserts ELEM in the proper position in LIST, which must be
-   sorted according to LESS given auxiliary data AUX.
-   Runs in O(n) average case in the number of elements in LIST. */
+   sorted according to LESS given auxiliary data AUX.  ELEM goes
+   after any elements equal to it.
+   Runs in O(n) average case in the number of elements in LIST,
+   but in O(1) time when ELEM belongs at the back. */
 void
 list_insert_ordered (struct list *list, struct list_elem *elem,
 		list_less_func *less, void *aux) {
@@ -424,6 +436,10 @@ list_insert_ordered (struct list *list, struct list_elem *elem,
 	ASSERT (elem != NULL);
 	ASSERT (less != NULL);
 
+	if (list_empty (list) || !less (elem, list_back (list), aux)) {
+		list_push_back (list, elem);
+		return;
+	}
 	for (e = list_begin (list); e != list_end (list); e = list_next (e))
 		if (less (elem, e, aux))
 			break;
@@ -487,3 +503,74 @@ list_min (struct list *list, list_less_func *less, void *aux) {
 	}
 	return min;
 }
+
+/* Initializes CLIST as an empty counted list. */
+void
+clist_init (struct clist *clist) {
+	ASSERT (clist != NULL);
+	list_init (&clist->list);
+	clist->size = 0;
+}
+
+/* Inserts ELEM at the beginning of CLIST. */
+void
+clist_push_front (struct clist *clist, struct list_elem *elem) {
+	list_push_front (&clist->list, elem);
+	clist->size++;
+}
+
+/* Inserts ELEM at the end of CLIST. */
+void
+clist_push_back (struct clist *clist, struct list_elem *elem) {
+	list_push_back (&clist->list, elem);
+	clist->size++;
+}
+
+/* Inserts ELEM in the proper position in CLIST, as
+   list_insert_ordered() does. */
+void
+clist_insert_ordered (struct clist *clist, struct list_elem *elem,
+		list_less_func *less, void *aux) {
+	list_insert_ordered (&clist->list, elem, less, aux);
+	clist->size++;
+}
+
+/* Removes ELEM, which must be in CLIST, and returns the element
+   that followed it. */
+struct list_elem *
+clist_remove (struct clist *clist, struct list_elem *elem) {
+	ASSERT (clist->size > 0);
+	clist->size--;
+	return list_remove (elem);
+}
+
+/* Removes the front element from CLIST and returns it.
+   Undefined behavior if CLIST is empty before removal. */
+struct list_elem *
+clist_pop_front (struct clist *clist) {
+	ASSERT (clist->size > 0);
+	clist->size--;
+	return list_pop_front (&clist->list);
+}
+
+/* Removes the back element from CLIST and returns it.
+   Undefined behavior if CLIST is empty before removal. */
+struct list_elem *
+clist_pop_back (struct clist *clist) {
+	ASSERT (clist->size > 0);
+	clist->size--;
+	return list_pop_back (&clist->list);
+}
+
+/* Returns the number of elements in CLIST.
+   Runs in O(1). */
+size_t
+clist_size (struct clist *clist) {
+	return clist->size;
+}
+
+/* Returns true if CLIST is empty, false otherwise. */
+bool
+clist_empty (struct clist *clist) {
+	return clist->size == 0;
+}
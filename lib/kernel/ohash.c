@@ -0,0 +1,452 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information.
+
+   Each array of slots is searched by linear probing from the
+   slot selected by the low bits of an element's hash value, its
+   "home".  Insertion uses the Robin Hood rule: an element that
+   is further from its home than the one occupying a slot takes
+   the slot, and the displaced element moves on.  This keeps
+   probe sequences short and lets a search stop as soon as it
+   meets an element closer to its home than the search has come.
+   Deletion shifts the following elements of the run back by one
+   slot instead of leaving a tombstone.
+
+   A table grows by allocating a new array twice the size and
+   moving elements over from the old array a few slots at a time
+   on each later insertion or deletion.  Moving an element is a
+   deletion from the old array, so the old array stays valid for
+   searching until it is empty and freed. */
+
+#include "ohash.h"
+#include <string.h>
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Number of slots in a new table. */
+#define MIN_SLOTS 16
+
+/* Slots of the old array examined on each insertion or deletion
+   while the table is growing.  The old array holds at most 3/4
+   as many elements as it has slots, and the new one has room for
+   that many insertions before it must grow in turn, so examining
+   more than 4/3 slots per insertion is enough to finish first. */
+#define MIGRATE_SLOTS 16
+
+static void table_insert (struct ohash_table *, struct ohash_elem *);
+static void table_remove (struct ohash_table *, size_t idx);
+static struct ohash_table *find_elem (struct ohash *, struct ohash_elem *,
+		size_t *idx);
+static void insert_elem (struct ohash *, struct ohash_elem *);
+static void migrate (struct ohash *, size_t slot_cnt);
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX. */
+bool
+ohash_init (struct ohash *h,
+		ohash_hash_func *hash, ohash_less_func *less, void *aux) {
+	h->elem_cnt = 0;
+	h->cur.slots = calloc (MIN_SLOTS, sizeof *h->cur.slots);
+	h->cur.mask = MIN_SLOTS - 1;
+	h->cur.elem_cnt = 0;
+	h->old.slots = NULL;
+	h->old.mask = 0;
+	h->old.elem_cnt = 0;
+	h->old_pos = 0;
+	h->hash = hash;
+	h->less = less;
+	h->aux = aux;
+	return h->cur.slots != NULL;
+}
+
+/* Calls DESTRUCTOR, if non-null, on each element in table T and
+   empties T. */
+static void
+table_clear (struct ohash *h, struct ohash_table *t,
+		ohash_action_func *destructor) {
+	size_t i;
+
+	if (t->slots == NULL)
+		return;
+	if (destructor != NULL)
+		for (i = 0; i <= t->mask; i++) {
+			struct ohash_elem *e = t->slots[i];
+			if (e != NULL) {
+				t->slots[i] = NULL;
+				destructor (e, h->aux);
+			}
+		}
+	t->elem_cnt = 0;
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere.
+
+   If H had grown, its array is swapped for a minimum-size one
+   when memory allows, so that an emptied table does not keep a
+   large allocation. */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor) {
+	table_clear (h, &h->old, destructor);
+	free (h->old.slots);
+	h->old.slots = NULL;
+
+	table_clear (h, &h->cur, destructor);
+	if (h->cur.mask + 1 > MIN_SLOTS) {
+		struct ohash_elem **slots = calloc (MIN_SLOTS, sizeof *slots);
+		if (slots != NULL) {
+			free (h->cur.slots);
+			h->cur.slots = slots;
+			h->cur.mask = MIN_SLOTS - 1;
+		}
+	}
+	if (h->cur.slots != NULL)
+		memset (h->cur.slots, 0, (h->cur.mask + 1) * sizeof *h->cur.slots);
+
+	h->elem_cnt = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash.  DESTRUCTOR may, if appropriate,
+   deallocate the memory used by the hash element.  However,
+   modifying hash table H while ohash_destroy() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done in DESTRUCTOR or
+   elsewhere. */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor) {
+	table_clear (h, &h->old, destructor);
+	table_clear (h, &h->cur, destructor);
+	free (h->old.slots);
+	free (h->cur.slots);
+	h->old.slots = h->cur.slots = NULL;
+	h->elem_cnt = 0;
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW. */
+struct ohash_elem *
+ohash_insert (struct ohash *h, struct ohash_elem *new) {
+	size_t idx;
+	struct ohash_table *t = find_elem (h, new, &idx);
+
+	if (t != NULL)
+		return t->slots[idx];
+	insert_elem (h, new);
+	return NULL;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned. */
+struct ohash_elem *
+ohash_replace (struct ohash *h, struct ohash_elem *new) {
+	size_t idx;
+	struct ohash_table *t = find_elem (h, new, &idx);
+	struct ohash_elem *old;
+
+	if (t == NULL) {
+		insert_elem (h, new);
+		return NULL;
+	}
+
+	/* NEW has the same hash value, so it belongs in the same
+	   slot. */
+	old = t->slots[idx];
+	t->slots[idx] = new;
+	return old;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct ohash_elem *
+ohash_find (struct ohash *h, struct ohash_elem *e) {
+	size_t idx;
+	struct ohash_table *t = find_elem (h, e, &idx);
+
+	return t != NULL ? t->slots[idx] : NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e) {
+	size_t idx;
+	struct ohash_table *t = find_elem (h, e, &idx);
+	struct ohash_elem *found;
+
+	if (t == NULL)
+		return NULL;
+	found = t->slots[idx];
+	table_remove (t, idx);
+	h->elem_cnt--;
+	migrate (h, MIGRATE_SLOTS);
+	return found;
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action) {
+	struct ohash_iterator i;
+
+	ASSERT (action != NULL);
+
+	ohash_first (&i, h);
+	while (ohash_next (&i))
+		action (ohash_cur (&i), h->aux);
+}
+
+/* Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+   struct ohash_iterator i;
+
+   ohash_first (&i, h);
+   while (ohash_next (&i)) {
+     struct foo *f = ohash_entry (ohash_cur (&i), struct foo, elem);
+     ...do something with f...
+   }
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators.  Searching with ohash_find() does not. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h) {
+	ASSERT (i != NULL);
+	ASSERT (h != NULL);
+
+	i->hash = h;
+	i->table = h->old.slots != NULL ? &h->old : &h->cur;
+	i->idx = 0;
+	i->elem = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order.
+
+   Modifying a hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators. */
+struct ohash_elem *
+ohash_next (struct ohash_iterator *i) {
+	ASSERT (i != NULL);
+
+	for (;;) {
+		struct ohash_table *t = i->table;
+
+		if (t->slots != NULL)
+			while (i->idx <= t->mask) {
+				struct ohash_elem *e = t->slots[i->idx++];
+				if (e != NULL)
+					return i->elem = e;
+			}
+		if (t != &i->hash->old)
+			return i->elem = NULL;
+		i->table = &i->hash->cur;
+		i->idx = 0;
+	}
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct ohash_elem *
+ohash_cur (struct ohash_iterator *i) {
+	return i->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) {
+	return h->elem_cnt == 0;
+}
+
+/* Returns how many slots element E, found in slot IDX of T, is
+   past its home slot. */
+static inline size_t
+probe_dist (const struct ohash_table *t, const struct ohash_elem *e,
+		size_t idx) {
+	return (idx - e->hash) & t->mask;
+}
+
+/* Searches table T of H for an element equal to E, whose `hash'
+   member must already be set.  If one is found, stores its slot
+   into *IDX and returns true.  Otherwise, returns false. */
+static bool
+table_find (struct ohash *h, struct ohash_table *t, struct ohash_elem *e,
+		size_t *idx) {
+	size_t i, dist;
+
+	if (t->slots == NULL || t->elem_cnt == 0)
+		return false;
+	for (i = e->hash & t->mask, dist = 0; ; i = (i + 1) & t->mask, dist++) {
+		struct ohash_elem *s = t->slots[i];
+
+		if (s == NULL || probe_dist (t, s, i) < dist)
+			return false;
+		if (s->hash == e->hash
+				&& !h->less (s, e, h->aux) && !h->less (e, s, h->aux)) {
+			*idx = i;
+			return true;
+		}
+	}
+}
+
+/* Computes E's hash value and searches H for an element equal
+   to E.  If one is found, stores its slot into *IDX and returns
+   the table that contains it.  Otherwise, returns a null
+   pointer. */
+static struct ohash_table *
+find_elem (struct ohash *h, struct ohash_elem *e, size_t *idx) {
+	e->hash = h->hash (e, h->aux);
+	if (table_find (h, &h->cur, e, idx))
+		return &h->cur;
+	if (h->old.slots != NULL && table_find (h, &h->old, e, idx))
+		return &h->old;
+	return NULL;
+}
+
+/* Inserts E, whose `hash' member must already be set, into table
+   T, which must have a free slot. */
+static void
+table_insert (struct ohash_table *t, struct ohash_elem *e) {
+	size_t i = e->hash & t->mask;
+	size_t dist = 0;
+
+	ASSERT (t->elem_cnt <= t->mask);
+	t->elem_cnt++;
+	for (;;) {
+		struct ohash_elem *s = t->slots[i];
+		size_t s_dist;
+
+		if (s == NULL) {
+			t->slots[i] = e;
+			return;
+		}
+
+		/* Take the slot from an element closer to its home. */
+		s_dist = probe_dist (t, s, i);
+		if (s_dist < dist) {
+			t->slots[i] = e;
+			e = s;
+			dist = s_dist;
+		}
+		i = (i + 1) & t->mask;
+		dist++;
+	}
+}
+
+/* Removes the element in slot IDX of table T, shifting the rest
+   of its run back to close the gap. */
+static void
+table_remove (struct ohash_table *t, size_t idx) {
+	ASSERT (t->elem_cnt > 0);
+
+	t->elem_cnt--;
+	for (;;) {
+		size_t next = (idx + 1) & t->mask;
+		struct ohash_elem *s = t->slots[next];
+
+		if (s == NULL || probe_dist (t, s, next) == 0)
+			break;
+		t->slots[idx] = s;
+		idx = next;
+	}
+	t->slots[idx] = NULL;
+}
+
+/* Starts growing H into an array twice the size of its current
+   one.  If memory is short, H keeps using its current array as
+   long as it has a free slot. */
+static void
+grow (struct ohash *h) {
+	size_t slot_cnt = (h->cur.mask + 1) * 2;
+	struct ohash_elem **slots;
+
+	/* Finish any earlier growth first. */
+	migrate (h, SIZE_MAX);
+
+	slots = calloc (slot_cnt, sizeof *slots);
+	if (slots == NULL) {
+		if (h->cur.elem_cnt > h->cur.mask)
+			PANIC ("out of memory growing hash table");
+		return;
+	}
+	h->old = h->cur;
+	h->old_pos = 0;
+	h->cur.slots = slots;
+	h->cur.mask = slot_cnt - 1;
+	h->cur.elem_cnt = 0;
+}
+
+/* Inserts E, whose `hash' member must already be set, into H,
+   which must not contain an element equal to E. */
+static void
+insert_elem (struct ohash *h, struct ohash_elem *e) {
+	migrate (h, MIGRATE_SLOTS);
+	if ((h->cur.elem_cnt + 1) * 4 > (h->cur.mask + 1) * 3)
+		grow (h);
+	table_insert (&h->cur, e);
+	h->elem_cnt++;
+}
+
+/* Examines up to SLOT_CNT slots of H's old array, moving each
+   element found into the current array, and frees the old array
+   once it is empty. */
+static void
+migrate (struct ohash *h, size_t slot_cnt) {
+	struct ohash_table *old = &h->old;
+
+	while (old->slots != NULL) {
+		if (old->elem_cnt == 0) {
+			free (old->slots);
+			old->slots = NULL;
+			break;
+		}
+		if (slot_cnt-- == 0)
+			break;
+
+		/* Removing an element may shift the next one into the
+		   same slot, so only advance past an empty slot.  The
+		   scan wraps around, since a shift that crosses the end
+		   of the array can move elements into slots already
+		   passed. */
+		if (old->slots[h->old_pos] != NULL) {
+			struct ohash_elem *e = old->slots[h->old_pos];
+			table_remove (old, h->old_pos);
+			table_insert (&h->cur, e);
+		} else
+			h->old_pos = (h->old_pos + 1) & old->mask;
+	}
+}
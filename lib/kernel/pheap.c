@@ -0,0 +1,173 @@
+#include "pheap.h"
+#include "../debug.h"
+
+/* Pairing heap, as described by Fredman, Sedgewick, Sleator, and
+   Tarjan, "The pairing heap: a new form of self-adjusting heap".
+
+   The heap is a tree in which no element is less than its
+   parent, so the root is the minimum.  Each element points to
+   its first child; the children of an element form a doubly
+   linked list through `next' and `prev', where the first child's
+   `prev' points back to the parent instead.
+
+   Insertion melds the new element with the root.  Removing the
+   root melds its children together in two passes, first in
+   pairs from left to right and then the results from right to
+   left, which is what gives the amortized O(lg n) bound. */
+
+/* Melds the heaps rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must have
+   no siblings or parent. */
+static struct pheap_elem *
+meld (struct pheap *heap, struct pheap_elem *a, struct pheap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (heap->less (b, a, heap->aux)) {
+		struct pheap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's first child. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds FIRST and all of its following siblings into a single
+   heap, using the two-pass method, and returns its root. */
+static struct pheap_elem *
+merge_pairs (struct pheap *heap, struct pheap_elem *first) {
+	struct pheap_elem *pairs = NULL;    /* Melded pairs, last first. */
+	struct pheap_elem *root = NULL;
+
+	/* Left to right, meld siblings in pairs.  The results are
+	   chained through `next' in reverse order. */
+	while (first != NULL) {
+		struct pheap_elem *a = first;
+		struct pheap_elem *b = a->next;
+
+		a->prev = a->next = NULL;
+		if (b != NULL) {
+			first = b->next;
+			b->prev = b->next = NULL;
+			a = meld (heap, a, b);
+		} else
+			first = NULL;
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Right to left, meld each pair into the accumulated heap. */
+	while (pairs != NULL) {
+		struct pheap_elem *a = pairs;
+
+		pairs = a->next;
+		a->next = NULL;
+		root = meld (heap, a, root);
+	}
+	return root;
+}
+
+/* Unlinks ELEM, which must not be the root, and the subtree
+   below it from the rest of HEAP. */
+static void
+detach (struct pheap_elem *elem) {
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->prev = elem->next = NULL;
+}
+
+/* Initializes HEAP to compare elements using LESS given
+   auxiliary data AUX. */
+void
+pheap_init (struct pheap *heap, pheap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->elem_cnt = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+pheap_push (struct pheap *heap, struct pheap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	heap->root = meld (heap, heap->root, elem);
+	heap->elem_cnt++;
+}
+
+/* Removes the least element from HEAP and returns it, or
+   returns a null pointer if HEAP is empty. */
+struct pheap_elem *
+pheap_pop (struct pheap *heap) {
+	struct pheap_elem *min = heap->root;
+
+	if (min != NULL) {
+		heap->root = merge_pairs (heap, min->child);
+		heap->elem_cnt--;
+	}
+	return min;
+}
+
+/* Removes ELEM, which must be in HEAP. */
+void
+pheap_remove (struct pheap *heap, struct pheap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (heap->elem_cnt > 0);
+
+	if (elem == heap->root) {
+		pheap_pop (heap);
+		return;
+	}
+	detach (elem);
+	heap->root = meld (heap, heap->root, merge_pairs (heap, elem->child));
+	heap->elem_cnt--;
+}
+
+/* Restores HEAP's ordering after ELEM, which must be in HEAP,
+   has become less than it was.  To make an element greater,
+   remove it and push it again instead. */
+void
+pheap_decrease (struct pheap *heap, struct pheap_elem *elem) {
+	ASSERT (heap != NULL);
+
+	if (elem == heap->root)
+		return;
+	detach (elem);
+	heap->root = meld (heap, heap->root, elem);
+}
+
+/* Returns the least element in HEAP, or a null pointer if HEAP
+   is empty. */
+struct pheap_elem *
+pheap_min (struct pheap *heap) {
+	return heap->root;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+pheap_size (struct pheap *heap) {
+	return heap->elem_cnt;
+}
+
+/* Returns true if HEAP contains no elements, false otherwise. */
+bool
+pheap_empty (struct pheap *heap) {
+	return heap->elem_cnt == 0;
+}
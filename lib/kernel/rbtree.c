@@ -0,0 +1,356 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Red-black tree, following the presentation in Cormen et al.,
+   "Introduction to Algorithms", except that leaves are null
+   pointers rather than a shared sentinel, so that a tree needs
+   no storage outside its elements.  Null leaves count as black.
+
+   The tree maintains the usual invariants:
+
+     - The root is black.
+     - A red element has no red child.
+     - Every path from an element down to a leaf passes through
+       the same number of black elements.
+
+   which together keep its height below 2 lg (n + 1). */
+
+/* Returns true if E is a red element, false if it is black or
+   a (null) leaf. */
+static inline bool
+is_red (const struct rb_elem *e) {
+	return e != NULL && e->red;
+}
+
+/* Returns the leftmost element in the subtree rooted at E. */
+static struct rb_elem *
+leftmost (struct rb_elem *e) {
+	while (e->left != NULL)
+		e = e->left;
+	return e;
+}
+
+/* Returns the rightmost element in the subtree rooted at E. */
+static struct rb_elem *
+rightmost (struct rb_elem *e) {
+	while (e->right != NULL)
+		e = e->right;
+	return e;
+}
+
+/* Makes V take U's place as a child of U's parent in TREE.
+   V may be null.  U's own links are not changed. */
+static void
+transplant (struct rb_tree *tree, struct rb_elem *u, struct rb_elem *v) {
+	if (u->parent == NULL)
+		tree->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Rotates X's right child up into X's place in TREE. */
+static void
+rotate_left (struct rb_tree *tree, struct rb_elem *x) {
+	struct rb_elem *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	transplant (tree, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates X's left child up into X's place in TREE. */
+static void
+rotate_right (struct rb_tree *tree, struct rb_elem *x) {
+	struct rb_elem *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	transplant (tree, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Initializes TREE to compare elements using LESS given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *tree, rb_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = NULL;
+	tree->min = NULL;
+	tree->elem_cnt = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts ELEM into TREE, after any elements equal to it. */
+void
+rb_insert (struct rb_tree *tree, struct rb_elem *elem) {
+	struct rb_elem *parent = NULL;
+	struct rb_elem **link = &tree->root;
+	bool is_min = true;
+
+	ASSERT (tree != NULL);
+	ASSERT (elem != NULL);
+
+	/* Find the leaf to replace. */
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (elem, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			is_min = false;
+		}
+	}
+	elem->parent = parent;
+	elem->left = elem->right = NULL;
+	elem->red = true;
+	*link = elem;
+	if (is_min)
+		tree->min = elem;
+	tree->elem_cnt++;
+
+	/* Repair any red element with a red parent. */
+	while (is_red (elem->parent)) {
+		struct rb_elem *p = elem->parent;
+		struct rb_elem *g = p->parent;
+
+		if (p == g->left) {
+			struct rb_elem *u = g->right;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				elem = g;
+			} else {
+				if (elem == p->right) {
+					rotate_left (tree, p);
+					p = elem;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_right (tree, g);
+				break;
+			}
+		} else {
+			struct rb_elem *u = g->left;
+
+			if (is_red (u)) {
+				p->red = u->red = false;
+				g->red = true;
+				elem = g;
+			} else {
+				if (elem == p->left) {
+					rotate_right (tree, p);
+					p = elem;
+				}
+				p->red = false;
+				g->red = true;
+				rotate_left (tree, g);
+				break;
+			}
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Finds and returns the first element in TREE equal to KEY, or
+   a null pointer if no element in TREE is equal to KEY. */
+struct rb_elem *
+rb_find (struct rb_tree *tree, const struct rb_elem *key) {
+	struct rb_elem *e = tree->root;
+	struct rb_elem *found = NULL;
+
+	while (e != NULL) {
+		if (tree->less (key, e, tree->aux))
+			e = e->left;
+		else if (tree->less (e, key, tree->aux))
+			e = e->right;
+		else {
+			found = e;
+			e = e->left;
+		}
+	}
+	return found;
+}
+
+/* Restores the black-height invariant after removing a black
+   element from TREE.  X, which may be a null leaf, has one black
+   element fewer on its paths than its sibling; PARENT is its
+   parent. */
+static void
+remove_fixup (struct rb_tree *tree, struct rb_elem *x,
+		struct rb_elem *parent) {
+	while (x != tree->root && !is_red (x)) {
+		if (x == parent->left) {
+			struct rb_elem *w = parent->right;
+
+			if (w->red) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (tree, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (tree, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (tree, parent);
+				x = tree->root;
+			}
+		} else {
+			struct rb_elem *w = parent->left;
+
+			if (w->red) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (tree, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->right) && !is_red (w->left)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (tree, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (tree, parent);
+				x = tree->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
+
+/* Removes ELEM, which must be in TREE. */
+void
+rb_remove (struct rb_tree *tree, struct rb_elem *elem) {
+	struct rb_elem *x, *parent;
+	bool removed_red = elem->red;
+
+	ASSERT (tree != NULL);
+	ASSERT (tree->elem_cnt > 0);
+
+	if (elem == tree->min)
+		tree->min = rb_next (elem);
+	tree->elem_cnt--;
+
+	if (elem->left == NULL) {
+		x = elem->right;
+		parent = elem->parent;
+		transplant (tree, elem, x);
+	} else if (elem->right == NULL) {
+		x = elem->left;
+		parent = elem->parent;
+		transplant (tree, elem, x);
+	} else {
+		/* Move ELEM's successor, which has no left child, into
+		   ELEM's place. */
+		struct rb_elem *y = leftmost (elem->right);
+
+		removed_red = y->red;
+		x = y->right;
+		if (y->parent == elem)
+			parent = y;
+		else {
+			parent = y->parent;
+			transplant (tree, y, x);
+			y->right = elem->right;
+			y->right->parent = y;
+		}
+		transplant (tree, elem, y);
+		y->left = elem->left;
+		y->left->parent = y;
+		y->red = elem->red;
+	}
+
+	if (!removed_red)
+		remove_fixup (tree, x, parent);
+}
+
+/* Removes the smallest element from TREE and returns it, or
+   returns a null pointer if TREE is empty. */
+struct rb_elem *
+rb_pop_min (struct rb_tree *tree) {
+	struct rb_elem *min = tree->min;
+
+	if (min != NULL)
+		rb_remove (tree, min);
+	return min;
+}
+
+/* Returns the smallest element in TREE, or a null pointer if
+   TREE is empty.  Runs in O(1). */
+struct rb_elem *
+rb_min (struct rb_tree *tree) {
+	return tree->min;
+}
+
+/* Returns the largest element in TREE, or a null pointer if
+   TREE is empty. */
+struct rb_elem *
+rb_max (struct rb_tree *tree) {
+	return tree->root != NULL ? rightmost (tree->root) : NULL;
+}
+
+/* Returns the element after ELEM in its tree, or a null pointer
+   if ELEM is the largest. */
+struct rb_elem *
+rb_next (struct rb_elem *elem) {
+	if (elem->right != NULL)
+		return leftmost (elem->right);
+	while (elem->parent != NULL && elem == elem->parent->right)
+		elem = elem->parent;
+	return elem->parent;
+}
+
+/* Returns the element before ELEM in its tree, or a null
+   pointer if ELEM is the smallest. */
+struct rb_elem *
+rb_prev (struct rb_elem *elem) {
+	if (elem->left != NULL)
+		return rightmost (elem->left);
+	while (elem->parent != NULL && elem == elem->parent->left)
+		elem = elem->parent;
+	return elem->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (struct rb_tree *tree) {
+	return tree->elem_cnt;
+}
+
+/* Returns true if TREE contains no elements, false otherwise. */
+bool
+rb_empty (struct rb_tree *tree) {
+	return tree->elem_cnt == 0;
+}
@@ -1,5 +1,50 @@
 #include <string.h>
 #include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* memcpy(), memset(), memcmp() and strlen() work a 64-bit word at
+   a time.  The first two use the x86 string instructions: "rep
+   movsb" and "rep stosb" alone on CPUs that advertise Enhanced
+   REP MOVSB/STOSB (ERMS), which makes them the fastest choice at
+   any size, and "rep movsq"/"rep stosq" with a byte-sized tail
+   otherwise.  The direction flag is clear on entry, both by the
+   ABI and because the kernel clears it on interrupts and system
+   calls.
+
+   Both the kernel and user programs are built with -mno-sse and
+   the kernel does not save SSE state across context switches, so
+   there are no SSE variants. */
+
+/* A 64-bit word that may be loaded from any address and may
+   alias any object. */
+typedef uint64_t __attribute__ ((may_alias, aligned (1))) word_t;
+
+/* Bytes of 0x01 and 0x80, for finding null bytes in a word. */
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+/* Returns true if the CPU supports Enhanced REP MOVSB/STOSB. */
+static bool
+have_erms (void) {
+	static int erms = -1;
+
+	if (erms < 0) {
+		uint32_t eax = 0, ebx, ecx = 0, edx;
+
+		/* Leaf 7, if supported, reports ERMS in EBX bit 9. */
+		asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+		erms = 0;
+		if (eax >= 7) {
+			eax = 7;
+			ecx = 0;
+			asm volatile ("cpuid"
+					: "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+			erms = (ebx >> 9) & 1;
+		}
+	}
+	return erms;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -11,8 +56,14 @@ memcpy (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+	if (!have_erms ()) {
+		size_t words = size / sizeof (uint64_t);
+		asm volatile ("rep movsq"
+				: "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+		size %= sizeof (uint64_t);
+	}
+	asm volatile ("rep movsb"
+			: "+D" (dst), "+S" (src), "+c" (size) : : "memory");
 
 	return dst_;
 }
@@ -52,6 +103,15 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	/* Skip equal words; the bytes of the first unequal one are
+	   compared below. */
+	for (; size >= sizeof (word_t); size -= sizeof (word_t)) {
+		if (*(const word_t *) a != *(const word_t *) b)
+			break;
+		a += sizeof (word_t);
+		b += sizeof (word_t);
+	}
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -260,8 +320,15 @@ memset (void *dst_, int value, size_t size) {
 
 	ASSERT (dst != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = value;
+	if (!have_erms ()) {
+		uint64_t pattern = (unsigned char) value * ONES;
+		size_t words = size / sizeof (uint64_t);
+		asm volatile ("rep stosq"
+				: "+D" (dst), "+c" (words) : "a" (pattern) : "memory");
+		size %= sizeof (uint64_t);
+	}
+	asm volatile ("rep stosb"
+			: "+D" (dst), "+c" (size) : "a" (value) : "memory");
 
 	return dst_;
 }
@@ -270,12 +337,24 @@ memset (void *dst_, int value, size_t size) {
 size_t
 strlen (const char *string) {
 	const char *p;
+	const uint64_t *w;
 
 	ASSERT (string);
 
-	for (p = string; *p != '\0'; p++)
-		continue;
-	return p - string;
+	/* Go byte by byte up to a word boundary... */
+	for (p = string; (uintptr_t) p % sizeof *w != 0; p++)
+		if (*p == '\0')
+			return p - string;
+
+	/* ...then a word at a time.  An aligned word never crosses a
+	   page boundary, so this reads no page that the string does
+	   not touch. */
+	for (w = (const uint64_t *) p; ; w++) {
+		uint64_t zeros = (*(const word_t *) w - ONES) & ~*(const word_t *) w
+			& HIGHS;
+		if (zeros != 0)
+			return (const char *) w + __builtin_ctzll (zeros) / 8 - string;
+	}
 }
 
 /* If STRING is less than MAXLEN characters in length, returns
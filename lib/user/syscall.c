@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -85,6 +85,28 @@ fork (const char *thread_name){
 	return (pid_t) syscall1 (SYS_FORK, thread_name);
 }
 
+/* The child returns from vfork() first and then goes on using
+   the parent's stack, where its next call would overwrite the
+   return address that the parent comes back to.  So vfork()
+   keeps its return address in %rdx, which the kernel preserves
+   across a system call, instead of on the stack. */
+__attribute__((naked)) pid_t
+vfork (void) {
+	__asm __volatile(
+			"pop %%rdx\n"
+			"mov %0, %%rax\n"
+			"syscall\n"
+			"push %%rdx\n"
+			"ret\n"
+			: : "i" (SYS_VFORK));
+}
+
+pid_t
+spawn (const char *file, char *const argv[], const struct spawn_fd *fds,
+		int fd_cnt) {
+	return (pid_t) syscall4 (SYS_SPAWN, file, argv, fds, fd_cnt);
+}
+
 int
 exec (const char *file) {
 	return (pid_t) syscall1 (SYS_EXEC, file);
@@ -125,6 +147,46 @@ write (int fd, const void *buffer, unsigned size) {
 	return syscall3 (SYS_WRITE, fd, buffer, size);
 }
 
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+copy_file_range (int fd_in, int fd_out, unsigned length) {
+	return syscall3 (SYS_COPY_FILE_RANGE, fd_in, fd_out, length);
+}
+
+int
+sendfile (int fd_out, int fd_in, unsigned length) {
+	return syscall3 (SYS_SENDFILE, fd_out, fd_in, length);
+}
+
+int
+ioring_setup (struct ioring *ring) {
+	return syscall1 (SYS_IORING_SETUP, ring);
+}
+
+int
+ioring_enter (unsigned to_submit) {
+	return syscall1 (SYS_IORING_ENTER, to_submit);
+}
+
 void
 seek (int fd, unsigned position) {
 	syscall2 (SYS_SEEK, fd, position);
@@ -145,6 +207,16 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
+int
+poll (struct pollfd *fds, unsigned nfds, int timeout) {
+	return syscall3 (SYS_POLL, fds, nfds, timeout);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -0,0 +1,18 @@
+#ifndef TESTS_CYCLES_H
+#define TESTS_CYCLES_H
+
+#include <stdint.h>
+
+/* Returns the CPU's time-stamp counter, which benchmarks use to
+   report their cost in cycles.  Usable from both kernel and user
+   tests. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+#endif /* tests/cycles.h */
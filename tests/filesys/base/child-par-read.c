@@ -0,0 +1,50 @@
+/* Child process for par-read test.
+   Reads the file belonging to this child PASS_CNT times, a
+   block at a time, and checks the contents each time. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/filesys/base/par-read.h"
+
+const char *test_name = "child-par-read";
+
+static char expected[FILE_SIZE];
+static char block[BLOCK_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  char file_name[16];
+  int child_idx;
+  int fd;
+  int pass;
+  size_t ofs;
+
+  quiet = true;
+  
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  snprintf (file_name, sizeof file_name, "par%d", child_idx);
+
+  random_init (child_idx);
+  random_bytes (expected, sizeof expected);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (pass = 0; pass < PASS_CNT; pass++) 
+    {
+      seek (fd, 0);
+      for (ofs = 0; ofs < sizeof expected; ofs += sizeof block) 
+        {
+          CHECK (read (fd, block, sizeof block) == (int) sizeof block,
+                 "read \"%s\"", file_name);
+          compare_bytes (block, expected + ofs, sizeof block, ofs,
+                         file_name);
+        }
+    }
+  close (fd);
+
+  return child_idx;
+}
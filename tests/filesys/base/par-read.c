@@ -0,0 +1,42 @@
+/* Spawns 10 child processes, each of which reads a different
+   file of its own over and over in sector-sized blocks.  Unlike
+   syn-read, the children never touch the same file, so with
+   per-file locking their disk reads may overlap; the "Timer"
+   line printed at shutdown gives the time the whole run took. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/filesys/base/par-read.h"
+
+static char buf[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  quiet = true;
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      char file_name[16];
+      int fd;
+
+      snprintf (file_name, sizeof file_name, "par%d", i);
+      random_init (i);
+      random_bytes (buf, sizeof buf);
+      CHECK (create (file_name, sizeof buf), "create \"%s\"", file_name);
+      CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+      CHECK (write (fd, buf, sizeof buf) == (int) sizeof buf,
+             "write \"%s\"", file_name);
+      close (fd);
+    }
+  quiet = false;
+  msg ("created %d files", CHILD_CNT);
+
+  exec_children ("child-par-read", children, CHILD_CNT);
+  wait_children (children, CHILD_CNT);
+}
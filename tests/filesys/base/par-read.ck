@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(par-read) begin
+(par-read) created 10 files
+(par-read) exec child 1 of 10: "child-par-read 0"
+(par-read) exec child 2 of 10: "child-par-read 1"
+(par-read) exec child 3 of 10: "child-par-read 2"
+(par-read) exec child 4 of 10: "child-par-read 3"
+(par-read) exec child 5 of 10: "child-par-read 4"
+(par-read) exec child 6 of 10: "child-par-read 5"
+(par-read) exec child 7 of 10: "child-par-read 6"
+(par-read) exec child 8 of 10: "child-par-read 7"
+(par-read) exec child 9 of 10: "child-par-read 8"
+(par-read) exec child 10 of 10: "child-par-read 9"
+(par-read) wait for child 1 of 10 returned 0 (expected 0)
+(par-read) wait for child 2 of 10 returned 1 (expected 1)
+(par-read) wait for child 3 of 10 returned 2 (expected 2)
+(par-read) wait for child 4 of 10 returned 3 (expected 3)
+(par-read) wait for child 5 of 10 returned 4 (expected 4)
+(par-read) wait for child 6 of 10 returned 5 (expected 5)
+(par-read) wait for child 7 of 10 returned 6 (expected 6)
+(par-read) wait for child 8 of 10 returned 7 (expected 7)
+(par-read) wait for child 9 of 10 returned 8 (expected 8)
+(par-read) wait for child 10 of 10 returned 9 (expected 9)
+(par-read) end
+EOF
+pass;
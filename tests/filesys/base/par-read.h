@@ -0,0 +1,9 @@
+#ifndef TESTS_FILESYS_BASE_PAR_READ_H
+#define TESTS_FILESYS_BASE_PAR_READ_H
+
+#define CHILD_CNT 10
+#define FILE_SIZE 8192
+#define BLOCK_SIZE 512
+#define PASS_CNT 8
+
+#endif /* tests/filesys/base/par-read.h */
@@ -0,0 +1,124 @@
+/* Test and benchmark for bitmap_scan() in lib/kernel/bitmap.c.
+
+   Checks bitmap_scan() against a straightforward bit-by-bit scan
+   on random bitmaps, then times both on a large, mostly allocated
+   bitmap like the free map of a big disk.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Largest bitmap used in the correctness test. */
+#define MAX_BITS 300
+
+/* Size of the bitmap used in the benchmark. */
+#define BENCH_BITS (64 * 1024)
+
+/* Number of scans timed per implementation. */
+#define BENCH_SCANS 200
+
+static size_t scan_bitwise (const struct bitmap *, size_t start, size_t cnt,
+                            bool value);
+static void verify_scan (void);
+static void bench_scan (void);
+
+void
+test (void) 
+{
+  verify_scan ();
+  bench_scan ();
+  printf ("done\n");
+}
+
+/* Compares bitmap_scan() with scan_bitwise() on random bitmaps
+   of random density. */
+static void
+verify_scan (void) 
+{
+  int repeat;
+
+  printf ("testing bitmap_scan on random bitmaps...");
+  for (repeat = 0; repeat < 2000; repeat++) 
+    {
+      size_t bit_cnt = random_ulong () % MAX_BITS;
+      int density = random_ulong () % 100;
+      struct bitmap *b = bitmap_create (bit_cnt);
+      size_t i;
+      int query;
+
+      ASSERT (b != NULL);
+      for (i = 0; i < bit_cnt; i++)
+        if ((int) (random_ulong () % 100) < density)
+          bitmap_mark (b, i);
+
+      for (query = 0; query < 20; query++) 
+        {
+          size_t start = random_ulong () % (bit_cnt + 1);
+          size_t cnt = random_ulong () % 70;
+          bool value = random_ulong () % 2;
+
+          ASSERT (bitmap_scan (b, start, cnt, value)
+                  == scan_bitwise (b, start, cnt, value));
+        }
+      bitmap_destroy (b);
+    }
+  printf (" ok\n");
+}
+
+/* Times bitmap_scan() and scan_bitwise() searching for a few
+   free bits at the end of a large bitmap whose first 15/16 are
+   allocated. */
+static void
+bench_scan (void) 
+{
+  struct bitmap *b = bitmap_create (BENCH_BITS);
+  size_t used = BENCH_BITS / 16 * 15;
+  size_t expect;
+  int64_t start;
+  int i;
+
+  ASSERT (b != NULL);
+  bitmap_set_multiple (b, 0, used, true);
+  expect = used;
+
+  start = timer_ticks ();
+  for (i = 0; i < BENCH_SCANS; i++)
+    ASSERT (scan_bitwise (b, 0, 8, false) == expect);
+  printf ("bit-by-bit scan: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (i = 0; i < BENCH_SCANS; i++)
+    ASSERT (bitmap_scan (b, 0, 8, false) == expect);
+  printf ("bitmap_scan: %"PRId64" ticks\n", timer_elapsed (start));
+
+  bitmap_destroy (b);
+}
+
+/* Reference implementation of bitmap_scan(), testing every
+   candidate run bit by bit. */
+static size_t
+scan_bitwise (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t bit_cnt = bitmap_size (b);
+  size_t i, j;
+
+  if (cnt > bit_cnt)
+    return BITMAP_ERROR;
+  for (i = start; i <= bit_cnt - cnt; i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
@@ -1,7 +1,9 @@
-/* Test program for lib/kernel/list.c.
+/* Test program for lib/kernel/list.c, rbtree.c, and pheap.c.
 
    Attempts to test the list functionality that is not
-   sufficiently tested elsewhere in Pintos.
+   sufficiently tested elsewhere in Pintos, checks red-black
+   trees and pairing heaps against sorted lists, and then
+   compares how fast each of them works as a priority queue.
 
    This is not a test we will run on your submitted projects.
    It is here for completeness.
@@ -9,27 +11,47 @@
 
 #undef NDEBUG
 #include <debug.h>
+#include <inttypes.h>
 #include <list.h>
+#include <pheap.h>
 #include <random.h>
+#include <rbtree.h>
 #include <stdio.h>
+#include "devices/timer.h"
 #include "threads/test.h"
 
 /* Maximum number of elements in a linked list that we will
    test. */
 #define MAX_SIZE 64
 
+/* Number of elements in the priority queues compared by the
+   performance test, and how many times each is filled and
+   drained. */
+#define PERF_SIZE 1024
+#define PERF_REPEAT 64
+
 /* A linked list element. */
 struct value 
   {
     struct list_elem elem;      /* List element. */
+    struct rb_elem rb_elem;     /* Red-black tree element. */
+    struct pheap_elem heap_elem; /* Pairing heap element. */
     int value;                  /* Item value. */
   };
 
 static void shuffle (struct value[], size_t);
 static bool value_less (const struct list_elem *, const struct list_elem *,
                         void *);
+static bool rb_value_less (const struct rb_elem *, const struct rb_elem *,
+                           void *);
+static bool heap_value_less (const struct pheap_elem *,
+                             const struct pheap_elem *, void *);
 static void verify_list_fwd (struct list *, int size);
 static void verify_list_bkwd (struct list *, int size);
+static void test_clist (void);
+static void test_rbtree (void);
+static void test_pheap (void);
+static void test_performance (void);
 
 /* Test the linked list implementation. */
 void
@@ -105,7 +127,243 @@ test (void)
     }
   
   printf (" done\n");
+
+  test_clist ();
+  test_rbtree ();
+  test_pheap ();
   printf ("list: PASS\n");
+
+  test_performance ();
+}
+
+/* Checks that a counted list keeps its size through every kind
+   of insertion and removal. */
+static void
+test_clist (void) 
+{
+  static struct value values[MAX_SIZE];
+  struct clist clist;
+  int i;
+
+  clist_init (&clist);
+  ASSERT (clist_empty (&clist));
+  for (i = 0; i < MAX_SIZE; i++) 
+    {
+      values[i].value = i;
+      if (i % 3 == 0)
+        clist_push_back (&clist, &values[i].elem);
+      else if (i % 3 == 1)
+        clist_push_front (&clist, &values[i].elem);
+      else
+        clist_insert_ordered (&clist, &values[i].elem, value_less, NULL);
+      ASSERT (clist_size (&clist) == (size_t) i + 1);
+      ASSERT (clist_size (&clist) == list_size (&clist.list));
+    }
+  for (i = 0; i < MAX_SIZE / 2; i++)
+    clist_remove (&clist, &values[i].elem);
+  ASSERT (clist_size (&clist) == MAX_SIZE - MAX_SIZE / 2);
+  while (!clist_empty (&clist))
+    if (clist_size (&clist) % 2)
+      clist_pop_front (&clist);
+    else
+      clist_pop_back (&clist);
+  ASSERT (list_empty (&clist.list));
+}
+
+/* Inserts values in random order into a red-black tree, removes
+   some of them, and checks that the rest come out in order. */
+static void
+test_rbtree (void) 
+{
+  int size;
+
+  printf ("testing red-black trees:");
+  for (size = 0; size < MAX_SIZE; size++) 
+    {
+      static struct value values[MAX_SIZE];
+      struct rb_tree tree;
+      struct rb_elem *e;
+      int i, expected;
+
+      for (i = 0; i < size; i++)
+        values[i].value = i;
+      shuffle (values, size);
+
+      rb_init (&tree, rb_value_less, NULL);
+      for (i = 0; i < size; i++)
+        rb_insert (&tree, &values[i].rb_elem);
+      ASSERT (rb_size (&tree) == (size_t) size);
+
+      /* Remove the odd values. */
+      for (i = 0; i < size; i++)
+        if (values[i].value % 2)
+          rb_remove (&tree, &values[i].rb_elem);
+      ASSERT (rb_size (&tree) == (size_t) (size + 1) / 2);
+
+      /* The even values are left, in order both ways. */
+      for (expected = 0, e = rb_min (&tree); e != NULL;
+           expected += 2, e = rb_next (e))
+        ASSERT (rb_entry (e, struct value, rb_elem)->value == expected);
+      ASSERT (expected == (size + 1) / 2 * 2);
+      for (e = rb_max (&tree); e != NULL; e = rb_prev (e))
+        ASSERT (rb_entry (e, struct value, rb_elem)->value == (expected -= 2));
+      ASSERT (expected == 0);
+
+      /* Look each value up. */
+      for (i = 0; i < size; i++) 
+        {
+          e = rb_find (&tree, &values[i].rb_elem);
+          ASSERT (values[i].value % 2 ? e == NULL : e == &values[i].rb_elem);
+        }
+
+      for (expected = 0; !rb_empty (&tree); expected += 2)
+        ASSERT (rb_entry (rb_pop_min (&tree), struct value, rb_elem)->value
+                == expected);
+      ASSERT (rb_pop_min (&tree) == NULL);
+      printf (" %d", size);
+    }
+  printf (" done\n");
+}
+
+/* Inserts values in random order into a pairing heap, removes
+   or lowers some of them, and checks that the rest come out in
+   order. */
+static void
+test_pheap (void) 
+{
+  int size;
+
+  printf ("testing pairing heaps:");
+  for (size = 0; size < MAX_SIZE; size++) 
+    {
+      static struct value values[MAX_SIZE];
+      struct pheap heap;
+      int i, expected;
+
+      for (i = 0; i < size; i++)
+        values[i].value = i * 2;
+      shuffle (values, size);
+
+      pheap_init (&heap, heap_value_less, NULL);
+      for (i = 0; i < size; i++)
+        pheap_push (&heap, &values[i].heap_elem);
+      ASSERT (pheap_size (&heap) == (size_t) size);
+
+      /* Pop the minimum once, so that the heap is no longer a
+         single list of children. */
+      if (size > 0) 
+        {
+          struct pheap_elem *min = pheap_pop (&heap);
+          ASSERT (pheap_entry (min, struct value, heap_elem)->value == 0);
+        }
+
+      /* Remove multiples of 4, and turn the other values V into
+         V - 1. */
+      for (i = 0; i < size; i++)
+        if (values[i].value == 0)
+          continue;
+        else if (values[i].value % 4 == 0)
+          pheap_remove (&heap, &values[i].heap_elem);
+        else 
+          {
+            values[i].value--;
+            pheap_decrease (&heap, &values[i].heap_elem);
+          }
+
+      for (expected = 1; !pheap_empty (&heap); expected += 4)
+        ASSERT (pheap_entry (pheap_pop (&heap), struct value,
+                             heap_elem)->value == expected);
+      ASSERT (expected == size / 2 * 4 + 1);
+      ASSERT (pheap_pop (&heap) == NULL);
+      printf (" %d", size);
+    }
+  printf (" done\n");
+}
+
+/* Fills and drains a priority queue of PERF_SIZE random values
+   PERF_REPEAT times each as a sorted list, a red-black tree, and
+   a pairing heap, and reports how long each took.  Then compares
+   list_size() with clist_size() on the same list. */
+static void
+test_performance (void) 
+{
+  static struct value values[PERF_SIZE];
+  struct clist clist;
+  struct rb_tree tree;
+  struct pheap heap;
+  int64_t start;
+  size_t total;
+  int i, repeat;
+
+  for (i = 0; i < PERF_SIZE; i++)
+    values[i].value = random_ulong () % PERF_SIZE;
+
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT; repeat++) 
+    {
+      struct list list;
+
+      list_init (&list);
+      for (i = 0; i < PERF_SIZE; i++)
+        list_insert_ordered (&list, &values[i].elem, value_less, NULL);
+      while (!list_empty (&list))
+        list_pop_front (&list);
+    }
+  printf ("sorted list:    %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT; repeat++) 
+    {
+      struct list list;
+
+      list_init (&list);
+      for (i = 0; i < PERF_SIZE; i++)
+        list_push_back (&list, &values[i].elem);
+      list_sort (&list, value_less, NULL);
+      while (!list_empty (&list))
+        list_pop_front (&list);
+    }
+  printf ("list_sort:      %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT; repeat++) 
+    {
+      rb_init (&tree, rb_value_less, NULL);
+      for (i = 0; i < PERF_SIZE; i++)
+        rb_insert (&tree, &values[i].rb_elem);
+      while (!rb_empty (&tree))
+        rb_pop_min (&tree);
+    }
+  printf ("red-black tree: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT; repeat++) 
+    {
+      pheap_init (&heap, heap_value_less, NULL);
+      for (i = 0; i < PERF_SIZE; i++)
+        pheap_push (&heap, &values[i].heap_elem);
+      while (!pheap_empty (&heap))
+        pheap_pop (&heap);
+    }
+  printf ("pairing heap:   %"PRId64" ticks\n", timer_elapsed (start));
+
+  clist_init (&clist);
+  for (i = 0; i < PERF_SIZE; i++)
+    clist_push_back (&clist, &values[i].elem);
+
+  total = 0;
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT * 16; repeat++)
+    total += list_size (&clist.list);
+  printf ("list_size:      %"PRId64" ticks\n", timer_elapsed (start));
+  ASSERT (total == (size_t) PERF_SIZE * PERF_REPEAT * 16);
+
+  total = 0;
+  start = timer_ticks ();
+  for (repeat = 0; repeat < PERF_REPEAT * 16; repeat++)
+    total += clist_size (&clist);
+  printf ("clist_size:     %"PRId64" ticks\n", timer_elapsed (start));
+  ASSERT (total == (size_t) PERF_SIZE * PERF_REPEAT * 16);
 }
 
 /* Shuffles the CNT elements in ARRAY into random order. */
@@ -135,6 +393,30 @@ value_less (const struct list_elem *a_, const struct list_elem *b_,
   return a->value < b->value;
 }
 
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+rb_value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct value *a = rb_entry (a_, struct value, rb_elem);
+  const struct value *b = rb_entry (b_, struct value, rb_elem);
+  
+  return a->value < b->value;
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+heap_value_less (const struct pheap_elem *a_, const struct pheap_elem *b_,
+                 void *aux UNUSED) 
+{
+  const struct value *a = pheap_entry (a_, struct value, heap_elem);
+  const struct value *b = pheap_entry (b_, struct value, heap_elem);
+  
+  return a->value < b->value;
+}
+
 /* Verifies that LIST contains the values 0...SIZE when traversed
    in forward order. */
 static void
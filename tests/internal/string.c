@@ -0,0 +1,125 @@
+/* Test and benchmark for memcpy(), memset(), memcmp() and
+   strlen() in lib/string.c.
+
+   Checks each function against a byte-at-a-time version at
+   every alignment, then reports the throughput of each, in bytes
+   per CPU cycle, for a range of sizes.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/cycles.h"
+#include "threads/test.h"
+
+/* Largest size benchmarked. */
+#define MAX_SIZE 16384
+
+/* Bytes moved per size class in the benchmark. */
+#define BENCH_BYTES (4 * 1024 * 1024)
+
+static char src[MAX_SIZE + 64], dst[MAX_SIZE + 64];
+
+static void verify (void);
+static void bench (void);
+
+void
+test (void) 
+{
+  verify ();
+  bench ();
+  printf ("done\n");
+}
+
+/* Checks the functions against byte loops for sizes up to 100
+   bytes at all 8 source and destination alignments. */
+static void
+verify (void) 
+{
+  size_t size, sa, da, i;
+
+  printf ("testing string functions...");
+  random_bytes (src, sizeof src);
+  for (size = 0; size < 100; size++)
+    for (sa = 0; sa < 8; sa++)
+      for (da = 0; da < 8; da++) 
+        {
+          memset (dst, 0x5a, sizeof dst);
+          memcpy (dst + da, src + sa, size);
+          for (i = 0; i < size; i++)
+            ASSERT (dst[da + i] == src[sa + i]);
+          ASSERT (dst[da + size] == 0x5a);
+          ASSERT (memcmp (dst + da, src + sa, size) == 0);
+
+          if (size > 0) 
+            {
+              dst[da + size - 1]++;
+              ASSERT (memcmp (dst + da, src + sa, size) > 0);
+              ASSERT (memcmp (src + sa, dst + da, size) < 0);
+            }
+
+          memset (dst + da, 'x', size);
+          dst[da + size] = '\0';
+          for (i = 0; i < size; i++)
+            ASSERT (dst[da + i] == 'x');
+          ASSERT (strlen (dst + da) == size);
+        }
+  printf (" ok\n");
+}
+
+/* Prints "NAME SIZE: X.YY bytes/cycle" for BYTES bytes handled
+   in CYCLES cycles. */
+static void
+report (const char *name, size_t size, uint64_t bytes, uint64_t cycles) 
+{
+  uint64_t rate = cycles > 0 ? bytes * 100 / cycles : 0;
+  printf ("%s %zu: %"PRIu64".%02"PRIu64" bytes/cycle\n",
+          name, size, rate / 100, rate % 100);
+}
+
+/* Times each function for sizes from 16 bytes to MAX_SIZE. */
+static void
+bench (void) 
+{
+  size_t size;
+
+  memset (src, 'a', MAX_SIZE);
+  src[MAX_SIZE] = '\0';
+  for (size = 16; size <= MAX_SIZE; size *= 4) 
+    {
+      size_t reps = BENCH_BYTES / size;
+      uint64_t start;
+      size_t i;
+      int sum = 0;
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        memcpy (dst, src, size);
+      report ("memcpy", size, BENCH_BYTES, rdtsc () - start);
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        memset (dst, i, size);
+      report ("memset", size, BENCH_BYTES, rdtsc () - start);
+
+      memcpy (dst, src, size);
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        sum += memcmp (dst, src, size);
+      report ("memcmp", size, BENCH_BYTES, rdtsc () - start);
+      ASSERT (sum == 0);
+
+      start = rdtsc ();
+      for (i = 0; i < reps; i++)
+        sum += strlen (src + MAX_SIZE - size);
+      report ("strlen", size, BENCH_BYTES, rdtsc () - start);
+      ASSERT (sum == (int) (reps * size));
+    }
+}
@@ -0,0 +1,68 @@
+/* Benchmark for thread creation and destruction in
+   threads/thread.c.
+
+   Repeatedly creates batches of threads that exit immediately and
+   reports how many were created and reaped per timer tick.  The
+   first round starts with an empty cache of thread pages; later
+   rounds reuse the pages of the threads before them.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/test.h"
+
+/* Threads per batch. */
+#define BATCH 8
+
+/* Batches per round. */
+#define BATCHES 500
+
+/* Number of rounds. */
+#define ROUNDS 4
+
+static thread_func exit_at_once;
+
+void
+test (void) 
+{
+  struct semaphore done;
+  int round;
+
+  sema_init (&done, 0);
+  for (round = 0; round < ROUNDS; round++) 
+    {
+      int64_t start = timer_ticks ();
+      int64_t elapsed;
+      int batch, i;
+
+      for (batch = 0; batch < BATCHES; batch++) 
+        {
+          for (i = 0; i < BATCH; i++)
+            ASSERT (thread_create ("bench", PRI_DEFAULT, exit_at_once, &done)
+                    != TID_ERROR);
+          for (i = 0; i < BATCH; i++)
+            sema_down (&done);
+        }
+      elapsed = timer_elapsed (start);
+      printf ("round %d: %d threads in %"PRId64" ticks (%"PRId64" per tick)\n",
+              round, BATCH * BATCHES, elapsed,
+              elapsed > 0 ? BATCH * BATCHES / elapsed : (int64_t) BATCH * BATCHES);
+    }
+  printf ("done\n");
+}
+
+/* Signals the semaphore DONE_ and exits. */
+static void
+exit_at_once (void *done_) 
+{
+  struct semaphore *done = done_;
+  sema_up (done);
+}
@@ -33,6 +33,29 @@ sub check_expected {
     compare_output ("run", @options, \@output, $expected);
 }
 
+# Checks the output of a benchmark, whose numbers cannot be known
+# in advance.  The run must be clean, and between its begin and
+# end messages the test must print, for each regular expression
+# in @TIMINGS, a line made of the test's name in parentheses, a
+# space, and a match for the expression.
+sub check_timings {
+    my (@timings) = @_;
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+
+    @output = get_core_output ("run", @output);
+    my ($name) = $test =~ m%([^/]+)$%;
+    fail "missing begin in output"
+      unless grep ($_ eq "($name) begin", @output);
+    foreach my $timing (@timings) {
+	fail "missing timing in output: $timing"
+	  unless grep (/^\(\Q$name\E\) $timing$/, @output);
+    }
+    fail "missing end in output"
+      unless grep ($_ eq "($name) end", @output);
+    pass;
+}
+
 sub common_checks {
     my ($run, @output) = @_;
 
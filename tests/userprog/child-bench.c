@@ -0,0 +1,21 @@
+/* Child process run by exec-bench.
+   Exits with argc if it was run as "child-bench a b c ...",
+   with argv null-terminated, or -1 otherwise. */
+
+#include <string.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-bench";
+
+int
+main (int argc, char *argv[])
+{
+  int i;
+
+  if (argc < 1 || strcmp (argv[0], "child-bench") || argv[argc] != NULL)
+    return -1;
+  for (i = 1; i < argc; i++)
+    if (argv[i][0] != 'a' + i - 1 || argv[i][1] != '\0')
+      return -1;
+  return argc;
+}
@@ -0,0 +1,78 @@
+/* Copies one file into another with copy_file_range(), at
+   sector-aligned and unaligned positions, and checks the
+   result.  Also checks that a copy within one file onto an
+   overlapping range is refused. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE 3000
+
+static char data[FILE_SIZE];
+static char expected[FILE_SIZE];
+
+static int
+create_and_open (const char *file_name) 
+{
+  int fd;
+
+  CHECK (create (file_name, FILE_SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  return fd;
+}
+
+static void
+copy (int src, int dst, unsigned length, int expected_cnt) 
+{
+  int copied = copy_file_range (src, dst, length);
+  if (copied != expected_cnt)
+    fail ("copy_file_range() returned %d instead of %d", copied,
+          expected_cnt);
+}
+
+void
+test_main (void) 
+{
+  int src, dst, dup;
+
+  random_bytes (data, sizeof data);
+  src = create_and_open ("src.data");
+  CHECK (write (src, data, sizeof data) == sizeof data,
+         "write \"src.data\"");
+  dst = create_and_open ("dst.data");
+
+  msg ("copy at sector-aligned positions");
+  seek (src, 0);
+  copy (src, dst, 1024, 1024);
+
+  msg ("copy at unaligned positions");
+  seek (src, 1024);
+  seek (dst, 1024);
+  copy (src, dst, 100, 100);
+  copy (src, dst, 100000, FILE_SIZE - 1124);
+  copy (src, dst, 1, 0);
+
+  msg ("copy to a different offset");
+  seek (src, 7);
+  seek (dst, 2000);
+  copy (src, dst, 1000, 1000);
+  if (tell (src) != 1007 || tell (dst) != 3000)
+    fail ("positions are %u and %u, not 1007 and 3000",
+          tell (src), tell (dst));
+
+  msg ("copy onto overlapping range of same file");
+  CHECK ((dup = open ("dst.data")) > 1, "open \"dst.data\" again");
+  seek (dst, 500);
+  copy (dst, dup, 1000, -1);
+
+  close (src);
+  close (dst);
+  close (dup);
+
+  memcpy (expected, data, sizeof data);
+  memcpy (expected + 2000, data + 7, 1000);
+  check_file ("dst.data", expected, sizeof expected);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-file-range) begin
+(copy-file-range) create "src.data"
+(copy-file-range) open "src.data"
+(copy-file-range) write "src.data"
+(copy-file-range) create "dst.data"
+(copy-file-range) open "dst.data"
+(copy-file-range) copy at sector-aligned positions
+(copy-file-range) copy at unaligned positions
+(copy-file-range) copy to a different offset
+(copy-file-range) copy onto overlapping range of same file
+(copy-file-range) open "dst.data" again
+(copy-file-range) open "dst.data" for verification
+(copy-file-range) verified contents of "dst.data"
+(copy-file-range) close "dst.data"
+(copy-file-range) end
+copy-file-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Measures the latency of exec by forking and executing a small
+   child program many times, and reports the average number of
+   CPU cycles per fork, exec, exit and wait.  Every exec after the
+   first finds the child's segment layout already cached.  The
+   child checks that its arguments arrived intact. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 50
+
+void
+test_main (void)
+{
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < EXEC_CNT; i++)
+    {
+      pid_t child = fork ("child-bench");
+
+      if (child == 0)
+        {
+          exec ("child-bench a b c d e f g");
+          exit (-1);
+        }
+      if (wait (child) != 8)
+        fail ("exec %d: child did not receive its arguments", i);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("%d execs, %"PRIu64" cycles per exec", EXEC_CNT, cycles / EXEC_CNT);
+}
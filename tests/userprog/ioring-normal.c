@@ -0,0 +1,114 @@
+/* Opens, writes, reads and closes a file through a submission
+   ring, queueing each stage as one batch, and checks every
+   completion. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK 16
+
+static struct ioring ring;
+static char buf[sizeof sample];
+
+/* Submits everything queued in the ring and checks that all of
+   it completes, each with the result given by EXPECTED. */
+static void
+submit_all (const char *what, int64_t (*expected) (uint64_t user_data)) 
+{
+  unsigned queued = ring.sq_tail - ring.sq_head;
+  struct ioring_cqe *cqe;
+  int done;
+
+  done = ioring_enter (queued);
+  if (done != (int) queued)
+    fail ("ioring_enter() performed %d of %u %s", done, queued, what);
+  while ((cqe = ioring_peek_cqe (&ring)) != NULL) 
+    {
+      if (cqe->res != expected (cqe->user_data))
+        fail ("%s %llu returned %lld instead of %lld", what,
+              (unsigned long long) cqe->user_data, (long long) cqe->res,
+              (long long) expected (cqe->user_data));
+      ioring_cqe_seen (&ring);
+    }
+  msg ("%s: %u completions", what, queued);
+}
+
+/* Returns the length of the chunk numbered IDX. */
+static int64_t
+chunk_size (uint64_t idx) 
+{
+  size_t size = sizeof sample - 1;
+  size_t ofs = idx * CHUNK;
+  return size - ofs < CHUNK ? size - ofs : CHUNK;
+}
+
+static int64_t
+zero (uint64_t user_data UNUSED) 
+{
+  return 0;
+}
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t chunk_cnt = (size + CHUNK - 1) / CHUNK;
+  struct ioring_sqe *sqe;
+  struct ioring_cqe *cqe;
+  size_t i;
+  int fd;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK (ioring_setup (&ring) == 0, "ioring_setup");
+
+  sqe = ioring_get_sqe (&ring);
+  sqe->opcode = IORING_OP_OPEN;
+  sqe->addr = (uintptr_t) "test.txt";
+  CHECK (ioring_enter (1) == 1, "submit open \"test.txt\"");
+  CHECK ((cqe = ioring_peek_cqe (&ring)) != NULL, "reap open");
+  fd = cqe->res;
+  ioring_cqe_seen (&ring);
+  if (fd < 2)
+    fail ("open through ring returned %d", fd);
+
+  /* Write the chunks last to first at explicit offsets. */
+  for (i = chunk_cnt; i-- > 0; ) 
+    {
+      sqe = ioring_get_sqe (&ring);
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = fd;
+      sqe->addr = (uintptr_t) (sample + i * CHUNK);
+      sqe->len = chunk_size (i);
+      sqe->off = i * CHUNK;
+      sqe->user_data = i;
+    }
+  submit_all ("write", chunk_size);
+  if (tell (fd) != 0)
+    fail ("positional writes moved position to %u", tell (fd));
+
+  /* Read them back first to last at the current position. */
+  for (i = 0; i < chunk_cnt; i++) 
+    {
+      sqe = ioring_get_sqe (&ring);
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = fd;
+      sqe->addr = (uintptr_t) (buf + i * CHUNK);
+      sqe->len = chunk_size (i);
+      sqe->user_data = i;
+    }
+  submit_all ("read", chunk_size);
+  compare_bytes (buf, sample, size, 0, "test.txt");
+
+  sqe = ioring_get_sqe (&ring);
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = fd;
+  sqe = ioring_get_sqe (&ring);
+  sqe->opcode = IORING_OP_NOP;
+  submit_all ("close", zero);
+
+  check_file ("test.txt", sample, size);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ioring-normal) begin
+(ioring-normal) create "test.txt"
+(ioring-normal) ioring_setup
+(ioring-normal) submit open "test.txt"
+(ioring-normal) reap open
+(ioring-normal) write: 24 completions
+(ioring-normal) read: 24 completions
+(ioring-normal) close: 2 completions
+(ioring-normal) open "test.txt" for verification
+(ioring-normal) verified contents of "test.txt"
+(ioring-normal) close "test.txt"
+(ioring-normal) end
+ioring-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,22 @@
+/* Passes the open system call a file name that starts in the
+   last bytes of the stack page and runs into the unmapped page
+   above it.  Only its first byte is a valid pointer.
+   The process must be terminated with -1 exit code. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Top of the user stack, from include/threads/vaddr.h. */
+#define USER_STACK 0x47480000
+
+void
+test_main (void) 
+{
+  char *name = (char *) USER_STACK - 3;
+
+  memcpy (name, "abc", 3);
+  msg ("open(\"abc...\"): %d", open (name));
+  fail ("should have called exit(-1)");
+}
@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(open-bad-bound) begin
+open-bad-bound: exit(-1)
+EOF
+pass;
@@ -0,0 +1,85 @@
+/* Measures how fast one process can pass data to another, first
+   through a pipe and then through a file that the parent reads
+   after the child has written it, and reports the average
+   number of CPU cycles per kB for each. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK_SIZE 4096
+#define TOTAL_SIZE (256 * 1024)
+
+static char buf[CHUNK_SIZE];
+
+/* Writes TOTAL_SIZE bytes to FD, a chunk at a time, and exits. */
+static void
+write_all (int fd)
+{
+  int i;
+
+  for (i = 0; i < TOTAL_SIZE / CHUNK_SIZE; i++)
+    if (write (fd, buf, CHUNK_SIZE) != CHUNK_SIZE)
+      exit (-1);
+  exit (0);
+}
+
+/* Reads FD to end of file and returns the number of bytes read. */
+static int
+read_all (int fd)
+{
+  int total = 0;
+  int n;
+
+  while ((n = read (fd, buf, CHUNK_SIZE)) > 0)
+    total += n;
+  return total;
+}
+
+/* Reports CYCLES spent passing TOTAL_SIZE bytes as NAME. */
+static void
+report (const char *name, uint64_t cycles)
+{
+  msg ("%s: %d kB, %"PRIu64" cycles per kB", name, TOTAL_SIZE / 1024,
+       cycles / (TOTAL_SIZE / 1024));
+}
+
+void
+test_main (void)
+{
+  uint64_t begin;
+  int fds[2];
+  pid_t pid;
+  int fd;
+
+  CHECK (create ("data", TOTAL_SIZE), "create \"data\"");
+
+  begin = rdtsc ();
+  if (pipe (fds) != 0)
+    fail ("pipe");
+  pid = fork ("writer");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      write_all (fds[1]);
+    }
+  close (fds[1]);
+  if (read_all (fds[0]) != TOTAL_SIZE || wait (pid) != 0)
+    fail ("pipe: data lost");
+  close (fds[0]);
+  report ("pipe", rdtsc () - begin);
+
+  begin = rdtsc ();
+  pid = fork ("writer");
+  if (pid == 0)
+    write_all (open ("data"));
+  if (wait (pid) != 0)
+    fail ("file: writer failed");
+  fd = open ("data");
+  if (read_all (fd) != TOTAL_SIZE)
+    fail ("file: data lost");
+  close (fd);
+  report ("file", rdtsc () - begin);
+}
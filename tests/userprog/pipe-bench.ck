@@ -0,0 +1,5 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_timings (map ("$_: 256 kB, \\d+ cycles per kB", 'pipe', 'file'));
@@ -0,0 +1,41 @@
+/* Forks a child that makes the write end of a pipe its standard
+   output with dup2() and then runs child-simple, whose message
+   the parent reads back out of the pipe. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[128];
+  size_t ofs;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      if (dup2 (fds[1], 1) != 1)
+        exit (-1);
+      close (fds[0]);
+      close (fds[1]);
+      exec ("child-simple");
+      exit (-1);
+    }
+
+  close (fds[1]);
+  ofs = 0;
+  while ((n = read (fds[0], buf + ofs, sizeof buf - 1 - ofs)) > 0)
+    ofs += n;
+  buf[ofs] = '\0';
+  if (ofs > 0 && buf[ofs - 1] == '\n')
+    buf[ofs - 1] = '\0';
+  msg ("read \"%s\"", buf);
+  CHECK (wait (pid) == 81, "wait for child");
+}
@@ -0,0 +1,59 @@
+/* Creates a pipe and forks a child that writes a message into it
+   a few bytes at a time, while the parent reads the message back
+   until end of file.  Also checks that each end of a pipe refuses
+   the other end's kind of access, and that writing fails once
+   no read end is left. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char message[] =
+  "Amazing Electronic Fact: If you scuffed your feet long enough "
+  "without touching anything, you would build up so many electrons "
+  "that your finger would explode!  But this is nothing to worry "
+  "about unless you have carpeting.";
+
+void
+test_main (void) 
+{
+  char buf[sizeof message];
+  size_t ofs;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (read (fds[1], buf, 1) == -1, "read from write end fails");
+  CHECK (write (fds[0], message, 1) == -1, "write to read end fails");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      for (ofs = 0; ofs < sizeof message; ofs += 7)
+        {
+          int size = sizeof message - ofs < 7 ? sizeof message - ofs : 7;
+          if (write (fds[1], message + ofs, size) != size)
+            exit (-1);
+        }
+      exit (0);
+    }
+
+  /* The child's write end is the only one left, so end of file
+     comes when the child exits. */
+  close (fds[1]);
+  ofs = 0;
+  while ((n = read (fds[0], buf + ofs, sizeof buf - ofs)) > 0)
+    ofs += n;
+  CHECK (n == 0, "read to end of file");
+  CHECK (ofs == sizeof message && !memcmp (buf, message, sizeof message),
+         "compare data");
+  CHECK (wait (pid) == 0, "wait for child");
+  close (fds[0]);
+
+  CHECK (pipe (fds) == 0, "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], message, 1) == -1, "write with no read end fails");
+}
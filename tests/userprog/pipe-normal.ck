@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-normal) begin
+(pipe-normal) pipe
+(pipe-normal) read from write end fails
+(pipe-normal) write to read end fails
+child: exit(0)
+(pipe-normal) read to end of file
+(pipe-normal) compare data
+(pipe-normal) wait for child
+(pipe-normal) pipe
+(pipe-normal) write with no read end fails
+(pipe-normal) end
+pipe-normal: exit(0)
+EOF
+pass;
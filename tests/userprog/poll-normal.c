@@ -0,0 +1,65 @@
+/* Polls both ends of a pipe, the console and a descriptor that is
+   not open, then forks a child that writes a message into the
+   pipe while the parent polls the read end with no timeout, so
+   that it must be woken by the write.  Reads the message back
+   and checks that the read end reports hangup once the child's
+   write end is closed. */
+
+#include <poll.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char message[] = "Polling beats spinning.";
+
+void
+test_main (void) 
+{
+  char buf[sizeof message];
+  struct pollfd pfds[4];
+  int woken, woken_revents, hup, hup_revents;
+  size_t ofs;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  pfds[0] = (struct pollfd) { .fd = fds[0], .events = POLLIN };
+  pfds[1] = (struct pollfd) { .fd = fds[1], .events = POLLOUT };
+  pfds[2] = (struct pollfd) { .fd = 1, .events = POLLOUT };
+  pfds[3] = (struct pollfd) { .fd = 100, .events = POLLIN };
+  CHECK (poll (pfds, 4, 0) == 3, "poll without waiting");
+  CHECK (pfds[0].revents == 0, "empty read end is not ready");
+  CHECK (pfds[1].revents == POLLOUT, "write end is writable");
+  CHECK (pfds[2].revents == POLLOUT, "console is writable");
+  CHECK (pfds[3].revents == POLLNVAL, "closed fd is invalid");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      if (write (fds[1], message, sizeof message) != sizeof message)
+        exit (-1);
+      exit (0);
+    }
+
+  /* Report nothing until end of file, which comes after the
+     child's exit message. */
+  close (fds[1]);
+  pfds[0] = (struct pollfd) { .fd = fds[0], .events = POLLIN };
+  woken = poll (pfds, 1, -1);
+  woken_revents = pfds[0].revents;
+  ofs = 0;
+  while ((n = read (fds[0], buf + ofs, sizeof buf - ofs)) > 0)
+    ofs += n;
+  hup = poll (pfds, 1, -1);
+  hup_revents = pfds[0].revents;
+
+  CHECK (woken == 1 && (woken_revents & POLLIN), "poll wakes for data");
+  CHECK (n == 0 && ofs == sizeof message
+         && !memcmp (buf, message, sizeof message), "read message");
+  CHECK (hup == 1 && hup_revents == POLLHUP, "poll reports hangup");
+  CHECK (wait (pid) == 0, "wait for child");
+}
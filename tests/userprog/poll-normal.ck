@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(poll-normal) begin
+(poll-normal) pipe
+(poll-normal) poll without waiting
+(poll-normal) empty read end is not ready
+(poll-normal) write end is writable
+(poll-normal) console is writable
+(poll-normal) closed fd is invalid
+child: exit(0)
+(poll-normal) poll wakes for data
+(poll-normal) read message
+(poll-normal) poll reports hangup
+(poll-normal) wait for child
+(poll-normal) end
+poll-normal: exit(0)
+EOF
+pass;
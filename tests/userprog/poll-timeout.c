@@ -0,0 +1,21 @@
+/* Polls the read end of a pipe that no one writes to, and an
+   empty set of descriptors, each with a timeout, and checks that
+   both calls return 0 when the timeout expires. */
+
+#include <poll.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct pollfd pfd;
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  pfd = (struct pollfd) { .fd = fds[0], .events = POLLIN };
+  CHECK (poll (&pfd, 1, 100) == 0, "poll empty pipe times out");
+  CHECK (pfd.revents == 0, "no events");
+  CHECK (poll (NULL, 0, 50) == 0, "poll nothing times out");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(poll-timeout) begin
+(poll-timeout) pipe
+(poll-timeout) poll empty pipe times out
+(poll-timeout) no events
+(poll-timeout) poll nothing times out
+(poll-timeout) end
+poll-timeout: exit(0)
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Writes a file back to front with pwrite(), reads pieces of it
+   with pread(), and checks that neither moves the file
+   position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buf[sizeof sample];
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = pwrite (handle, sample + half, size - half, half);
+  if (byte_cnt != (int) (size - half))
+    fail ("pwrite() returned %d instead of %zu", byte_cnt, size - half);
+  byte_cnt = pwrite (handle, sample, half, 0);
+  if (byte_cnt != (int) half)
+    fail ("pwrite() returned %d instead of %zu", byte_cnt, half);
+  if (tell (handle) != 0)
+    fail ("pwrite() moved position to %u", tell (handle));
+
+  byte_cnt = pread (handle, buf, 20, 10);
+  if (byte_cnt != 20)
+    fail ("pread() returned %d instead of 20", byte_cnt);
+  compare_bytes (buf, sample + 10, 20, 10, "test.txt");
+  if (tell (handle) != 0)
+    fail ("pread() moved position to %u", tell (handle));
+
+  byte_cnt = pread (handle, buf, sizeof buf, size - 5);
+  if (byte_cnt != 5)
+    fail ("pread() at end returned %d instead of 5", byte_cnt);
+  msg ("close \"test.txt\"");
+  close (handle);
+
+  check_file ("test.txt", sample, size);
+}
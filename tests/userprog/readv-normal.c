@@ -0,0 +1,43 @@
+/* Writes a file from three buffers with writev(), then reads it
+   back with readv() into four buffers split at different points
+   and checks that the contents survived the trip. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[1500];
+static char back[1500];
+
+void
+test_main (void) 
+{
+  struct iovec out[3] = {
+    { buf, 512 }, { buf + 512, 700 }, { buf + 1212, 288 },
+  };
+  struct iovec in[4] = {
+    { back, 1 }, { back + 1, 511 }, { back + 512, 1024 - 512 },
+    { back + 1024, 476 },
+  };
+  int handle, byte_cnt;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create ("test.data", sizeof buf), "create \"test.data\"");
+  CHECK ((handle = open ("test.data")) > 1, "open \"test.data\"");
+
+  byte_cnt = writev (handle, out, 3);
+  if (byte_cnt != sizeof buf)
+    fail ("writev() returned %d instead of %zu", byte_cnt, sizeof buf);
+  if (tell (handle) != sizeof buf)
+    fail ("writev() left position at %u", tell (handle));
+
+  msg ("seek \"test.data\" to 0");
+  seek (handle, 0);
+  byte_cnt = readv (handle, in, 4);
+  if (byte_cnt != sizeof back)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof back);
+  compare_bytes (back, buf, sizeof buf, 0, "test.data");
+  msg ("close \"test.data\"");
+  close (handle);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-normal) begin
+(readv-normal) create "test.data"
+(readv-normal) open "test.data"
+(readv-normal) seek "test.data" to 0
+(readv-normal) close "test.data"
+(readv-normal) end
+readv-normal: exit(0)
+EOF
+pass;
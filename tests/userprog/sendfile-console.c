@@ -0,0 +1,29 @@
+/* Sends a file to the console with sendfile(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char text[] = "Hello from sendfile!\n";
+
+void
+test_main (void) 
+{
+  int fd, sent;
+
+  CHECK (create ("hello.txt", sizeof text - 1), "create \"hello.txt\"");
+  CHECK ((fd = open ("hello.txt")) > 1, "open \"hello.txt\"");
+  CHECK (write (fd, text, sizeof text - 1) == sizeof text - 1,
+         "write \"hello.txt\"");
+  seek (fd, 0);
+
+  sent = sendfile (1, fd, 1000);
+  if (sent != sizeof text - 1)
+    fail ("sendfile() returned %d instead of %zu", sent, sizeof text - 1);
+  sent = sendfile (1, fd, 1000);
+  if (sent != 0)
+    fail ("sendfile() at end of file returned %d", sent);
+  msg ("close \"hello.txt\"");
+  close (fd);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-console) begin
+(sendfile-console) create "hello.txt"
+(sendfile-console) open "hello.txt"
+(sendfile-console) write "hello.txt"
+Hello from sendfile!
+(sendfile-console) close "hello.txt"
+(sendfile-console) end
+sendfile-console: exit(0)
+EOF
+pass;
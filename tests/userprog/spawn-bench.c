@@ -0,0 +1,77 @@
+/* Measures how fast processes can be started three ways: fork()
+   then exec(), vfork() then exec(), and spawn().  Each way starts
+   the same small child many times and waits for it, and the
+   average number of CPU cycles per child is reported.  The child
+   checks that its arguments arrived intact. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/cycles.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SPAWN_CNT 50
+
+static char *child_argv[] = {"child-bench", "a", "b", "c", "d", "e", "f",
+                             "g", NULL};
+
+/* Starts child-bench with fork() and exec(). */
+static pid_t
+start_fork (void)
+{
+  pid_t pid = fork ("child-bench");
+
+  if (pid == 0)
+    {
+      exec ("child-bench a b c d e f g");
+      exit (-1);
+    }
+  return pid;
+}
+
+/* Starts child-bench with vfork() and exec(). */
+static pid_t
+start_vfork (void)
+{
+  pid_t pid = vfork ();
+
+  if (pid == 0)
+    {
+      exec ("child-bench a b c d e f g");
+      exit (-1);
+    }
+  return pid;
+}
+
+/* Starts child-bench with spawn(). */
+static pid_t
+start_spawn (void)
+{
+  return spawn ("child-bench", child_argv, NULL, 0);
+}
+
+/* Starts and waits for SPAWN_CNT children with START and reports
+   the cycles taken per child as NAME. */
+static void
+bench (const char *name, pid_t (*start) (void))
+{
+  uint64_t begin, cycles;
+  int i;
+
+  begin = rdtsc ();
+  for (i = 0; i < SPAWN_CNT; i++)
+    if (wait (start ()) != 8)
+      fail ("%s %d: child did not receive its arguments", name, i);
+  cycles = rdtsc () - begin;
+
+  msg ("%s: %d children, %"PRIu64" cycles per child", name, SPAWN_CNT,
+       cycles / SPAWN_CNT);
+}
+
+void
+test_main (void)
+{
+  bench ("fork+exec", start_fork);
+  bench ("vfork+exec", start_vfork);
+  bench ("spawn", start_spawn);
+}
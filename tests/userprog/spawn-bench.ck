@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_timings (map ("$_: 50 children, \\d+ cycles per child",
+                    'fork\\+exec', 'vfork\\+exec', 'spawn'));
@@ -0,0 +1,28 @@
+/* Opens a file and spawns child-close with the file as its fd 5,
+   which child-close verifies and closes.  The parent's handle
+   must be unaffected.  Then spawns child-simple with no argument
+   vector and no files. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *argv[] = {"child-close", "5", NULL};
+  struct spawn_fd fds[] = {{0, 5}};
+  pid_t pid;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  fds[0].fd = handle;
+
+  pid = spawn ("child-close", argv, fds, 1);
+  msg ("wait(spawn()) = %d", wait (pid));
+  check_file_handle (handle, "sample.txt", sample, sizeof sample - 1);
+
+  pid = spawn ("child-simple", NULL, NULL, 0);
+  msg ("wait(spawn()) = %d", wait (pid));
+}
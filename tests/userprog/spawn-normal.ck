@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-normal) begin
+(spawn-normal) open "sample.txt"
+(child-close) begin
+(child-close) verified contents of "sample.txt"
+(child-close) end
+child-close: exit(0)
+(spawn-normal) wait(spawn()) = 0
+(spawn-normal) verified contents of "sample.txt"
+(child-simple) run
+child-simple: exit(81)
+(spawn-normal) wait(spawn()) = 81
+(spawn-normal) end
+spawn-normal: exit(0)
+EOF
+pass;
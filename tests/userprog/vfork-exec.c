@@ -0,0 +1,26 @@
+/* Creates children with vfork() that exec a program or exit
+   right away, and waits for them.  The parent must get its
+   address space back intact either way. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t pid;
+
+  pid = vfork ();
+  if (pid == 0)
+    {
+      exec ("child-simple");
+      exit (-1);
+    }
+  msg ("wait(vfork()+exec()) = %d", wait (pid));
+
+  pid = vfork ();
+  if (pid == 0)
+    exit (7);
+  msg ("wait(vfork()+exit()) = %d", wait (pid));
+}
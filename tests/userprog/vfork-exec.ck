@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vfork-exec) begin
+(child-simple) run
+child-simple: exit(81)
+(vfork-exec) wait(vfork()+exec()) = 81
+vfork-exec: exit(7)
+(vfork-exec) wait(vfork()+exit()) = 7
+(vfork-exec) end
+vfork-exec: exit(0)
+EOF
+pass;
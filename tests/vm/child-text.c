@@ -0,0 +1,30 @@
+/* Child process of text-shared.
+   Run with no arguments, executes a second copy of itself,
+   passing the frame that holds its code page, and returns the
+   second copy's exit code.  Run with that argument, exits with
+   code 81 if its code page is in the same frame, 1 otherwise. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-text";
+
+int
+main (int argc, char *argv[])
+{
+  int frame = (uintptr_t) get_phys_addr ((void *) main) >> 12;
+  char cmd[32];
+  pid_t child;
+
+  if (argc > 1)
+    return atoi (argv[1]) == frame ? 81 : 1;
+
+  snprintf (cmd, sizeof cmd, "child-text %d", frame);
+  child = fork ("child-text");
+  if (child == 0)
+    exec (cmd);
+  return wait (child);
+}
@@ -0,0 +1,31 @@
+/* Checks that the read-only code pages of a program are shared
+   between processes running it, both after fork and when the
+   program is executed again while it is still running. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  void *pa = get_phys_addr ((void *) test_main);
+  pid_t child;
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      CHECK (get_phys_addr ((void *) test_main) == pa,
+             "forked child shares code page");
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for forked child");
+
+  /* child-text runs a second copy of itself and exits with 81 if
+     that copy's code page is its own. */
+  child = fork ("child-text");
+  if (child == 0)
+    exec ("child-text");
+  CHECK (wait (child) == 81, "exec'd processes share code page");
+}
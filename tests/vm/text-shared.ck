@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(text-shared) begin
+(text-shared) forked child shares code page
+(text-shared) wait for forked child
+(text-shared) exec'd processes share code page
+(text-shared) end
+EOF
+pass;
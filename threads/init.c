@@ -20,6 +20,7 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -84,6 +85,7 @@ int main(void)
 	/* Initialize memory system. */
 	mem_end = palloc_init();
 	malloc_init();
+	kmem_init();
 	paging_init(mem_end);
 
 #ifdef USERPROG
@@ -368,6 +370,8 @@ print_stats(void)
 {
 	timer_print_stats();
 	thread_print_stats();
+	palloc_print_stats();
+	kmem_print_stats();
 #ifdef FILESYS
 	disk_print_stats();
 #endif
@@ -7,9 +7,10 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <list.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,13 +25,69 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are managed by a binary buddy
+   allocator.  Free memory is kept as blocks of 2**ORDER pages,
+   each aligned (relative to the pool base) to its own size, on
+   one free list per order.  A request for PAGE_CNT pages takes
+   the smallest block that fits, splitting larger blocks as
+   needed, and hands the pages beyond PAGE_CNT straight back.
+   Freeing merges a block with its buddy for as long as the buddy
+   is free too.  Both directions take O(log n) steps.
+
+   Single pages, by far the most common request, are served from a
+   per-pool magazine: a small stack of pages already taken from the
+   buddy allocator.  An empty magazine is refilled, and a full one
+   drained, MAGAZINE_BATCH pages at a time, so most single-page
+   allocations and frees never touch the free lists.
+
+   Each pool also keeps a stack of up to ZEROED_SIZE pages that
+   the idle thread has already cleared (see
+   palloc_prezero_page()), so that single-page PAL_ZERO requests,
+   such as new thread stacks and page tables, need not clear a
+   page on the spot.
+
+   Pages are freed from the scheduler with interrupts off (see
+   do_schedule() in thread.c), so the free lists and magazines are
+   protected by disabling interrupts rather than by a lock. */
+
+/* Order of the largest block tracked, 2**20 pages or 4 GB. */
+#define MAX_ORDER 20
+
+/* `orders' value for a page that does not start a free block. */
+#define NO_ORDER 0xff
+
+/* Capacity of a pool's magazine, and the number of pages moved
+   between it and the buddy allocator at a time. */
+#define MAGAZINE_SIZE 64
+#define MAGAZINE_BATCH 32
+
+/* Number of pre-zeroed pages kept per pool. */
+#define ZEROED_SIZE 32
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	size_t free_cnt;                /* Number of free pages. */
+
+	struct list free_lists[MAX_ORDER + 1];  /* Free blocks, by order. */
+	struct list_elem *links;        /* Free list element for each page. */
+	uint8_t *orders;                /* Order of the free block starting at
+	                                   each page, or NO_ORDER. */
+
+	size_t magazine[MAGAZINE_SIZE]; /* Cached single pages, by index. */
+	size_t mag_cnt;                 /* Number of pages in `magazine'. */
+	long long mag_gets, mag_get_hits;   /* Single-page allocations, and
+	                                       those served without a refill. */
+	long long mag_puts, mag_put_hits;   /* Single-page frees, and those
+	                                       absorbed without a drain. */
+
+	size_t zeroed[ZEROED_SIZE];     /* Pages known to be zero, by index. */
+	size_t zeroed_cnt;              /* Number of pages in `zeroed'. */
+	long long zero_gets, zero_hits;     /* Single-page PAL_ZERO requests, and
+	                                       those served from `zeroed'. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +99,19 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void release_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static size_t pages_alloc (struct pool *, size_t page_cnt, unsigned order);
+static size_t magazine_get (struct pool *);
+static void magazine_put (struct pool *, size_t page_idx);
+static void magazine_drain (struct pool *, size_t cnt);
+#ifndef NDEBUG
+static bool cached (const size_t *cache, size_t cnt,
+		size_t page_idx, size_t page_cnt);
+#endif
+static void zeroed_drain (struct pool *);
+static size_t block_alloc (struct pool *, unsigned order);
+static void block_free (struct pool *, size_t page_idx, unsigned order);
+static void print_pool_stats (const char *name, struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +293,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				release_pages (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				release_pages (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -262,19 +332,49 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	size_t page_idx = BITMAP_ERROR;
+	bool zeroed = false;
+	unsigned order = 0;
 	void *pages;
 
+	while (order <= MAX_ORDER && ((size_t) 1 << order) < page_cnt)
+		order++;
+
+	if (page_cnt > 0 && order <= MAX_ORDER) {
+		enum intr_level old_level = intr_disable ();
+		if (page_cnt == 1) {
+			if (flags & PAL_ZERO) {
+				pool->zero_gets++;
+				if (pool->zeroed_cnt > 0) {
+					page_idx = pool->zeroed[--pool->zeroed_cnt];
+					pool->zero_hits++;
+					zeroed = true;
+				}
+			}
+			if (page_idx == BITMAP_ERROR)
+				page_idx = magazine_get (pool);
+			if (page_idx == BITMAP_ERROR && pool->zeroed_cnt > 0)
+				page_idx = pool->zeroed[--pool->zeroed_cnt];
+		} else {
+			page_idx = pages_alloc (pool, page_cnt, order);
+			if (page_idx == BITMAP_ERROR
+					&& pool->mag_cnt + pool->zeroed_cnt > 0) {
+				/* Cached pages may be what stands in the way. */
+				magazine_drain (pool, pool->mag_cnt);
+				zeroed_drain (pool);
+				page_idx = pages_alloc (pool, page_cnt, order);
+			}
+		}
+		intr_set_level (old_level);
+	}
+
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
 	else
 		pages = NULL;
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -319,7 +419,18 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+
+	enum intr_level old_level = intr_disable ();
+	/* Pages in the magazine or the pre-zeroed stack stay marked
+	   used, so the bitmap check above cannot catch a second free
+	   of one of them. */
+	ASSERT (!cached (pool->magazine, pool->mag_cnt, page_idx, page_cnt));
+	ASSERT (!cached (pool->zeroed, pool->zeroed_cnt, page_idx, page_cnt));
+	if (page_cnt == 1)
+		magazine_put (pool, page_idx);
+	else
+		release_pages (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,6 +439,50 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Clears a free page and sets it aside for a later PAL_ZERO
+   request, if either pool is short of pre-zeroed pages and has a
+   page to spare.  Returns true if a page was cleared, false if
+   there was nothing to do.  Called by the idle thread, with
+   interrupts on, so the clearing itself costs no one any time. */
+bool
+palloc_prezero_page (void) {
+	struct pool *pools[] = { &kernel_pool, &user_pool };
+	size_t i;
+
+	for (i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *pool = pools[i];
+		enum intr_level old_level;
+		size_t page_idx;
+
+		if (pool->zeroed_cnt >= ZEROED_SIZE)
+			continue;
+
+		old_level = intr_disable ();
+		page_idx = pages_alloc (pool, 1, 0);
+		intr_set_level (old_level);
+		if (page_idx == BITMAP_ERROR)
+			continue;
+
+		memset (pool->base + PGSIZE * page_idx, 0, PGSIZE);
+
+		old_level = intr_disable ();
+		if (pool->zeroed_cnt < ZEROED_SIZE)
+			pool->zeroed[pool->zeroed_cnt++] = page_idx;
+		else
+			release_pages (pool, page_idx, 1);
+		intr_set_level (old_level);
+		return true;
+	}
+	return false;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	print_pool_stats ("kernel_pool", &kernel_pool);
+	print_pool_stats ("user_pool", &user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -336,15 +491,31 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t meta_pages = DIV_ROUND_UP (pgcnt * (sizeof *p->links
+				+ sizeof *p->orders), PGSIZE) * PGSIZE;
+	unsigned order;
 
-	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
+	p->free_cnt = 0;
+	p->mag_cnt = 0;
+	p->mag_gets = p->mag_get_hits = p->mag_puts = p->mag_put_hits = 0;
+	p->zeroed_cnt = 0;
+	p->zero_gets = p->zero_hits = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
-	*bm_base += bm_pages;
+	/* The buddy allocator's per-page bookkeeping follows the bitmap,
+	   rather than living in the free pages themselves, because not
+	   all of RAM is mapped yet at this point. */
+	for (order = 0; order <= MAX_ORDER; order++)
+		list_init (&p->free_lists[order]);
+	p->links = (struct list_elem *) ((uint8_t *) *bm_base + bm_pages);
+	p->orders = (uint8_t *) (p->links + pgcnt);
+	memset (p->orders, NO_ORDER, pgcnt);
+
+	*bm_base += bm_pages + meta_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -356,3 +527,196 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Marks the PAGE_CNT pages starting at PAGE_IDX in POOL free and
+   returns them to the buddy allocator, as the largest aligned
+   blocks that cover them.  Interrupts must be off, or the pool not
+   yet in use. */
+static void
+release_pages (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool->free_cnt += page_cnt;
+
+	while (page_cnt > 0) {
+		unsigned order = 0;
+
+		while (order < MAX_ORDER
+				&& page_idx % ((size_t) 2 << order) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		block_free (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Takes PAGE_CNT pages from POOL's buddy allocator, using a block
+   of 2**ORDER pages and giving back the part of it beyond
+   PAGE_CNT.  Returns the index of the first page, or BITMAP_ERROR
+   if no block is large enough.  Interrupts must be off. */
+static size_t
+pages_alloc (struct pool *pool, size_t page_cnt, unsigned order) {
+	size_t page_idx = block_alloc (pool, order);
+
+	if (page_idx != BITMAP_ERROR) {
+		size_t block_cnt = (size_t) 1 << order;
+		bitmap_set_multiple (pool->used_map, page_idx, block_cnt, true);
+		pool->free_cnt -= block_cnt;
+		release_pages (pool, page_idx + page_cnt, block_cnt - page_cnt);
+	}
+	return page_idx;
+}
+
+/* Returns the index of a page from POOL's magazine, refilling the
+   magazine first if it is empty, or BITMAP_ERROR if POOL is out of
+   pages.  Interrupts must be off. */
+static size_t
+magazine_get (struct pool *pool) {
+	pool->mag_gets++;
+	if (pool->mag_cnt > 0)
+		pool->mag_get_hits++;
+	else {
+		while (pool->mag_cnt < MAGAZINE_BATCH) {
+			size_t page_idx = pages_alloc (pool, 1, 0);
+			if (page_idx == BITMAP_ERROR)
+				break;
+			pool->magazine[pool->mag_cnt++] = page_idx;
+		}
+		if (pool->mag_cnt == 0)
+			return BITMAP_ERROR;
+	}
+	return pool->magazine[--pool->mag_cnt];
+}
+
+/* Puts the page at PAGE_IDX, which must be allocated, in POOL's
+   magazine, draining the magazine first if it is full.
+   Interrupts must be off. */
+static void
+magazine_put (struct pool *pool, size_t page_idx) {
+	pool->mag_puts++;
+	if (pool->mag_cnt < MAGAZINE_SIZE)
+		pool->mag_put_hits++;
+	else
+		magazine_drain (pool, MAGAZINE_BATCH);
+	pool->magazine[pool->mag_cnt++] = page_idx;
+}
+
+#ifndef NDEBUG
+/* Returns true if any of the CNT page indexes in CACHE falls among
+   the PAGE_CNT pages starting at PAGE_IDX. */
+static bool
+cached (const size_t *cache, size_t cnt, size_t page_idx, size_t page_cnt) {
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		if (cache[i] - page_idx < page_cnt)
+			return true;
+	return false;
+}
+#endif
+
+/* Returns the CNT most recently cached pages in POOL's magazine to
+   the buddy allocator.  Interrupts must be off. */
+static void
+magazine_drain (struct pool *pool, size_t cnt) {
+	ASSERT (cnt <= pool->mag_cnt);
+
+	while (cnt-- > 0)
+		release_pages (pool, pool->magazine[--pool->mag_cnt], 1);
+}
+
+/* Returns all of POOL's pre-zeroed pages to the buddy allocator.
+   Interrupts must be off. */
+static void
+zeroed_drain (struct pool *pool) {
+	while (pool->zeroed_cnt > 0)
+		release_pages (pool, pool->zeroed[--pool->zeroed_cnt], 1);
+}
+
+/* Removes a free block of 2**ORDER pages from POOL and returns the
+   index of its first page, or BITMAP_ERROR if there is none.
+   Splits a larger block if no block of that order is free.
+   Interrupts must be off. */
+static size_t
+block_alloc (struct pool *pool, unsigned order) {
+	unsigned k = order;
+	size_t page_idx;
+
+	while (k <= MAX_ORDER && list_empty (&pool->free_lists[k]))
+		k++;
+	if (k > MAX_ORDER)
+		return BITMAP_ERROR;
+
+	page_idx = list_pop_front (&pool->free_lists[k]) - pool->links;
+	pool->orders[page_idx] = NO_ORDER;
+
+	/* Put the upper halves back until the block is small enough. */
+	while (k > order) {
+		size_t buddy;
+
+		k--;
+		buddy = page_idx + ((size_t) 1 << k);
+		pool->orders[buddy] = k;
+		list_push_front (&pool->free_lists[k], &pool->links[buddy]);
+	}
+	return page_idx;
+}
+
+/* Adds the block of 2**ORDER pages starting at PAGE_IDX to POOL's
+   free lists, first merging it with its buddy, and the merged
+   block with its buddy, for as long as the buddy is free.
+   Interrupts must be off. */
+static void
+block_free (struct pool *pool, size_t page_idx, unsigned order) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+
+	ASSERT (page_idx % ((size_t) 1 << order) == 0);
+
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy >= pool_pages || pool->orders[buddy] != order)
+			break;
+		list_remove (&pool->links[buddy]);
+		pool->orders[buddy] = NO_ORDER;
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+
+	pool->orders[page_idx] = order;
+	list_push_front (&pool->free_lists[order], &pool->links[page_idx]);
+}
+
+/* Prints POOL's free page count, its free blocks by order, how
+   fragmented its free memory is (the share of free pages outside
+   the largest free block), how many single-page requests its
+   magazine handled without going to the free lists, and how many
+   PAL_ZERO requests found a page already cleared. */
+static void
+print_pool_stats (const char *name, struct pool *pool) {
+	size_t largest = 0;
+	unsigned order;
+
+	if (pool->used_map == NULL)
+		return;
+
+	printf ("%s: %zu of %zu pages free, %zu cached, %zu zeroed, "
+			"blocks by order:", name, pool->free_cnt,
+			bitmap_size (pool->used_map), pool->mag_cnt, pool->zeroed_cnt);
+	for (order = 0; order <= MAX_ORDER; order++) {
+		size_t cnt = list_size (&pool->free_lists[order]);
+		if (cnt > 0) {
+			printf (" %u:%zu", order, cnt);
+			largest = (size_t) 1 << order;
+		}
+	}
+	printf ("\n");
+	if (pool->free_cnt > 0)
+		printf ("%s: largest free block %zu pages, %zu%% fragmented\n", name,
+				largest, 100 - largest * 100 / pool->free_cnt);
+	printf ("%s: magazine served %lld of %lld page allocations, "
+			"%lld of %lld frees\n", name, pool->mag_get_hits, pool->mag_gets,
+			pool->mag_put_hits, pool->mag_puts);
+	printf ("%s: %lld of %lld single-page PAL_ZERO requests pre-zeroed\n",
+			name, pool->zero_hits, pool->zero_gets);
+}
@@ -0,0 +1,282 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches.
+
+   malloc() rounds every request up to a power of 2, so a
+   fixed-size structure that is allocated and freed all the time
+   can waste up to half of its memory, and each call walks the
+   descriptor table.  An object cache instead hands out objects of
+   exactly one size, carved out of page-sized "slabs".
+
+   Each slab begins with a `struct slab' header, followed by a
+   few bytes of padding and then as many objects as fit.  The
+   padding, or "color", differs from slab to slab in steps of
+   CACHE_LINE bytes, using up the slack at the end of the page,
+   so that objects at the same index in different slabs do not
+   all compete for the same cache lines.
+
+   A cache keeps its slabs on three lists: partial slabs, which
+   have both free and allocated objects and are allocated from
+   first; full slabs; and at most one empty slab, held back so
+   that a cache hovering around a slab boundary does not keep
+   going to the page allocator.
+
+   Free objects are chained through a pointer stored in the
+   object itself.  If the cache has a constructor, objects are
+   constructed once, when their slab is created, and must be in
+   their constructed state when freed; the free pointer is then
+   kept just past the object so that it does not clobber it. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Step between slab colors, in bytes. */
+#define CACHE_LINE 64
+
+/* An object cache. */
+struct kmem_cache {
+	struct list_elem elem;      /* Element in `caches'. */
+	const char *name;           /* Name, for statistics. */
+	void (*ctor) (void *);      /* Constructor, or a null pointer. */
+	size_t size;                /* Object size requested. */
+	size_t stride;              /* Distance between objects. */
+	size_t free_ofs;            /* Offset of free pointer in an object. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	size_t color_max;           /* Largest color offset. */
+	size_t color_next;          /* Color of the next slab created. */
+
+	struct lock lock;           /* Protects the members below. */
+	struct list partial;        /* Slabs with some objects free. */
+	struct list full;           /* Slabs with no objects free. */
+	struct list empty;          /* At most one slab with all free. */
+	size_t slab_cnt;            /* Number of slabs. */
+	size_t in_use;              /* Number of objects allocated. */
+	long long alloc_cnt;        /* Number of allocations. */
+	long long free_cnt;         /* Number of frees. */
+};
+
+/* Slab header, at the start of each slab's page. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of cache's lists. */
+	void *free;                 /* First free object. */
+	size_t in_use;              /* Number of objects allocated. */
+};
+
+/* All caches, for kmem_print_stats(). */
+static struct list caches;
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Returns the free pointer stored in free object OBJ of CACHE. */
+static inline void **
+free_ptr (struct kmem_cache *cache, void *obj) {
+	return (void **) ((uint8_t *) obj + cache->free_ofs);
+}
+
+/* Initializes the object cache layer. */
+void
+kmem_init (void) {
+	list_init (&caches);
+}
+
+/* Creates and returns a cache for SIZE-byte objects, named NAME.
+   If CTOR is nonnull, it is called on each object when its slab
+   is created.  Panics if SIZE is too large for a slab or memory
+   is not available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, void (*ctor) (void *)) {
+	struct kmem_cache *cache;
+	size_t room = PGSIZE - sizeof (struct slab);
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+
+	cache = malloc (sizeof *cache);
+	if (cache == NULL)
+		PANIC ("kmem_cache_create: out of memory");
+
+	cache->name = name;
+	cache->ctor = ctor;
+	cache->size = size;
+	cache->stride = ROUND_UP (size, sizeof (void *));
+	cache->free_ofs = 0;
+	if (ctor != NULL) {
+		cache->free_ofs = cache->stride;
+		cache->stride += sizeof (void *);
+	}
+	cache->objs_per_slab = room / cache->stride;
+	if (cache->objs_per_slab == 0)
+		PANIC ("kmem_cache_create: %zu-byte objects too large", size);
+	cache->color_max = room - cache->objs_per_slab * cache->stride;
+	cache->color_next = 0;
+
+	lock_init (&cache->lock);
+	list_init (&cache->partial);
+	list_init (&cache->full);
+	list_init (&cache->empty);
+	cache->slab_cnt = 0;
+	cache->in_use = 0;
+	cache->alloc_cnt = cache->free_cnt = 0;
+
+	list_push_back (&caches, &cache->elem);
+	return cache;
+}
+
+/* Obtains and returns an object from CACHE.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *cache) {
+	struct slab *s;
+	void *obj;
+
+	ASSERT (cache != NULL);
+
+	lock_acquire (&cache->lock);
+
+	/* Find a slab with a free object. */
+	if (list_empty (&cache->partial)) {
+		if (!list_empty (&cache->empty))
+			s = list_entry (list_pop_front (&cache->empty), struct slab, elem);
+		else {
+			s = slab_create (cache);
+			if (s == NULL) {
+				lock_release (&cache->lock);
+				return NULL;
+			}
+		}
+		list_push_front (&cache->partial, &s->elem);
+	}
+	s = list_entry (list_front (&cache->partial), struct slab, elem);
+
+	/* Take the object. */
+	obj = s->free;
+	s->free = *free_ptr (cache, obj);
+	if (++s->in_use == cache->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&cache->full, &s->elem);
+	}
+	cache->in_use++;
+	cache->alloc_cnt++;
+
+	lock_release (&cache->lock);
+	return obj;
+}
+
+/* Returns OBJ, which must have been obtained from CACHE, to
+   CACHE.  If CACHE has a constructor, OBJ must be in its
+   constructed state. */
+void
+kmem_cache_free (struct kmem_cache *cache, void *obj) {
+	struct slab *s;
+
+	if (obj == NULL)
+		return;
+
+	s = obj_to_slab (cache, obj);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs. */
+	if (cache->ctor == NULL)
+		memset (obj, 0xcc, cache->size);
+#endif
+
+	lock_acquire (&cache->lock);
+
+	*free_ptr (cache, obj) = s->free;
+	s->free = obj;
+	if (s->in_use-- == cache->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&cache->partial, &s->elem);
+	}
+	if (s->in_use == 0) {
+		list_remove (&s->elem);
+		if (list_empty (&cache->empty))
+			list_push_front (&cache->empty, &s->elem);
+		else {
+			s->magic = 0;
+			palloc_free_page (s);
+			cache->slab_cnt--;
+		}
+	}
+	cache->in_use--;
+	cache->free_cnt++;
+
+	lock_release (&cache->lock);
+}
+
+/* Prints statistics for each cache. */
+void
+kmem_print_stats (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&caches); e != list_end (&caches); e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+		printf ("%s cache: %zu-byte objects, %zu per slab, %zu in use, "
+				"%zu slabs, %lld allocs, %lld frees\n",
+				c->name, c->size, c->objs_per_slab, c->in_use,
+				c->slab_cnt, c->alloc_cnt, c->free_cnt);
+	}
+}
+
+/* Allocates a new slab for CACHE, colors it, constructs its
+   objects, and chains them onto its free list.  Returns the
+   slab, or a null pointer if memory is not available.  Must be
+   called with CACHE's lock held. */
+static struct slab *
+slab_create (struct kmem_cache *cache) {
+	struct slab *s = palloc_get_page (0);
+	uint8_t *obj;
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = cache;
+	s->free = NULL;
+	s->in_use = 0;
+
+	obj = (uint8_t *) (s + 1) + cache->color_next;
+	cache->color_next += CACHE_LINE;
+	if (cache->color_next > cache->color_max)
+		cache->color_next = 0;
+
+	/* Chain in reverse so that objects are handed out in address
+	   order. */
+	for (i = cache->objs_per_slab; i-- > 0; ) {
+		void *o = obj + i * cache->stride;
+		if (cache->ctor != NULL)
+			cache->ctor (o);
+		*free_ptr (cache, o) = s->free;
+		s->free = o;
+	}
+
+	cache->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab that OBJ, which must belong to CACHE, is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *cache, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid. */
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == cache);
+
+	return s;
+}
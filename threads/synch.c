@@ -353,6 +353,128 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 		cond_signal(cond, lock);
 }
 
+/* Initializes RWLOCK.  Any number of threads may hold a
+   readers-writer lock for reading at once, or a single thread
+   may hold it for writing.  Writers take precedence: once a
+   writer is waiting, new readers wait until it is done, so a
+   steady stream of readers cannot starve it out.  Like a lock,
+   an rwlock must be released by the thread that acquired it,
+   and must not be acquired twice by the same thread. */
+void rwlock_init(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	lock_init(&rwlock->lock);
+	cond_init(&rwlock->readers_ok);
+	cond_init(&rwlock->writer_ok);
+	rwlock->readers = 0;
+	rwlock->writers_waiting = 0;
+	rwlock->writer = false;
+}
+
+/* Acquires RWLOCK for reading, sleeping until no writer holds or
+   is waiting for it. */
+void rwlock_acquire_read(struct rwlock *rwlock)
+{
+	lock_acquire(&rwlock->lock);
+	while (rwlock->writer || rwlock->writers_waiting > 0)
+		cond_wait(&rwlock->readers_ok, &rwlock->lock);
+	rwlock->readers++;
+	lock_release(&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread holds for reading. */
+void rwlock_release_read(struct rwlock *rwlock)
+{
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock->readers > 0);
+	if (--rwlock->readers == 0 && rwlock->writers_waiting > 0)
+		cond_signal(&rwlock->writer_ok, &rwlock->lock);
+	lock_release(&rwlock->lock);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no other thread
+   holds it. */
+void rwlock_acquire_write(struct rwlock *rwlock)
+{
+	lock_acquire(&rwlock->lock);
+	rwlock->writers_waiting++;
+	while (rwlock->writer || rwlock->readers > 0)
+		cond_wait(&rwlock->writer_ok, &rwlock->lock);
+	rwlock->writers_waiting--;
+	rwlock->writer = true;
+	lock_release(&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread holds for writing.
+   Hands it to the next waiting writer if there is one, otherwise
+   to all waiting readers. */
+void rwlock_release_write(struct rwlock *rwlock)
+{
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock->writer);
+	rwlock->writer = false;
+	if (rwlock->writers_waiting > 0)
+		cond_signal(&rwlock->writer_ok, &rwlock->lock);
+	else
+		cond_broadcast(&rwlock->readers_ok, &rwlock->lock);
+	lock_release(&rwlock->lock);
+}
+
+/* Initializes wait queue Q as empty. */
+void waitq_init(struct waitq *q)
+{
+	list_init(&q->entries);
+}
+
+/* Adds ENTRY, for the current thread, to wait queue Q.  The
+   thread should look at the object Q belongs to only after this,
+   so that a change it does not see is sure to wake it. */
+void waitq_add(struct waitq *q, struct waitq_entry *entry)
+{
+	enum intr_level old_level;
+
+	entry->thread = thread_current();
+	entry->queue = q;
+	old_level = intr_disable();
+	list_push_back(&q->entries, &entry->elem);
+	intr_set_level(old_level);
+}
+
+/* Removes ENTRY from the wait queue it is in, if any. */
+void waitq_remove(struct waitq_entry *entry)
+{
+	enum intr_level old_level;
+
+	if (entry->queue == NULL)
+		return;
+	old_level = intr_disable();
+	list_remove(&entry->elem);
+	intr_set_level(old_level);
+	entry->queue = NULL;
+}
+
+/* Wakes every thread waiting in Q with thread_wait_event().  Call
+   it after making the change that the waiters are looking for.
+   Costs only a look at the list when no one is polling, which is
+   the usual case.  May be called from an interrupt handler. */
+void waitq_wake(struct waitq *q)
+{
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	barrier();
+	if (list_empty(&q->entries))
+		return;
+
+	old_level = intr_disable();
+	for (e = list_begin(&q->entries); e != list_end(&q->entries);
+		 e = list_next(e))
+		thread_wake_event(list_entry(e, struct waitq_entry, elem)->thread);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
 bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux)
 {
 	struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
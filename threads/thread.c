@@ -25,8 +25,9 @@
 #define THREAD_BASIC 0xd42df210
 
 /* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+   that are ready to run but not actually running.  Counted, so
+   that update_load_avg() in the timer interrupt need not walk it. */
+static struct clist ready_list;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -40,10 +41,20 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of recently destroyed threads, kept for thread_create() to
+   reuse without going through the page allocator or clearing the
+   whole page; init_thread() clears the struct thread and the rest
+   is stack.  Accessed with interrupts off. */
+#define THREAD_PAGE_CACHE_SIZE 16
+static void *thread_page_cache[THREAD_PAGE_CACHE_SIZE];
+static size_t thread_page_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
+static long long thread_pages_reused;    /* # of pages from the cache. */
+static long long thread_pages_allocated; /* # of pages from palloc. */
 
 /* Scheduling. */
 #define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
@@ -107,7 +118,7 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
+	clist_init(&ready_list);
 	list_init(&sleep_list);
 	list_init(&destruction_req);
 	list_init(&all_list);
@@ -165,6 +176,46 @@ void thread_print_stats(void)
 {
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
+	printf("Thread: %lld pages reused, %lld pages allocated\n",
+		   thread_pages_reused, thread_pages_allocated);
+}
+
+/* Returns a page for a new thread, from the cache of dead threads'
+   pages if possible.  Returns a null pointer if memory is not
+   available. */
+static void *
+thread_page_get(void)
+{
+	enum intr_level old_level = intr_disable();
+	void *page = NULL;
+
+	if (thread_page_cache_cnt > 0)
+	{
+		page = thread_page_cache[--thread_page_cache_cnt];
+		thread_pages_reused++;
+	}
+	intr_set_level(old_level);
+
+	if (page == NULL)
+	{
+		page = palloc_get_page(0);
+		if (page != NULL)
+			thread_pages_allocated++;
+	}
+	return page;
+}
+
+/* Caches the page of dead thread T for reuse, or frees it if the
+   cache is full.  Interrupts must be off. */
+static void
+thread_page_put(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (thread_page_cache_cnt < THREAD_PAGE_CACHE_SIZE)
+		thread_page_cache[thread_page_cache_cnt++] = t;
+	else
+		palloc_free_page(t);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -191,7 +242,7 @@ tid_t thread_create(const char *name, int priority,
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	t = thread_page_get();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -214,9 +265,6 @@ tid_t thread_create(const char *name, int priority,
 	thread_unblock(t);
 	test_max_priority();
 
-	/* file descriptor init */
-	t->fd_table = palloc_get_multiple(PAL_ZERO, 3);
-	t->fd_idx = 2;
 	list_push_back(&thread_current()->child_list, &t->child_elem);
 
 	return tid;
@@ -252,7 +300,7 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
+	clist_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
 	t->status = THREAD_READY;
 
 	intr_set_level(old_level);
@@ -322,7 +370,7 @@ void thread_yield(void)
 
 	old_level = intr_disable();
 	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
+		clist_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
@@ -402,6 +450,16 @@ idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* With nothing else to run, clear free pages ahead of
+		   PAL_ZERO requests, stopping as soon as an interrupt
+		   readies some thread. */
+		intr_enable();
+		while (clist_empty(&ready_list) && palloc_prezero_page())
+			continue;
+		intr_disable();
+		if (!clist_empty(&ready_list))
+			continue;
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -459,6 +517,12 @@ init_thread(struct thread *t, const char *name, int priority)
 	sema_init(&t->fork_sema, 0);
 	sema_init(&t->free_sema, 0);
 	sema_init(&t->wait_sema, 0);
+
+	t->fd_table = t->fd_inline;
+	t->fd_map = &t->fd_inline_map;
+	t->fd_cap = FD_INLINE;
+	t->fd_inline_map = 0;
+	t->fd_cnt = 0;
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -469,10 +533,10 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
+	if (clist_empty(&ready_list))
 		return idle_thread;
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		return list_entry(clist_pop_front(&ready_list), struct thread, elem);
 }
 
 /* Use iretq to launch the thread */
@@ -585,7 +649,7 @@ do_schedule(int status)
 	{
 		struct thread *victim =
 			list_entry(list_pop_front(&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		thread_page_put(victim);
 	}
 	thread_current()->status = status;
 	schedule();
@@ -668,6 +732,52 @@ void thread_sleep(int64_t ticks)
 	intr_set_level(old_level);
 }
 
+/* Blocks the current thread until thread_wake_event() is called
+ * on it or, if WAKEUP_TICK is not negative, until timer tick
+ * WAKEUP_TICK, whichever comes first.  Interrupts must be off, and
+ * the caller must have checked for the event it waits for since
+ * turning them off, so that a wakeup cannot slip in between. */
+void thread_wait_event(int64_t wakeup_tick)
+{
+	struct thread *curr = thread_current();
+
+	ASSERT(!intr_context());
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	curr->event_waiting = true;
+	curr->event_timed = wakeup_tick >= 0;
+	if (curr->event_timed)
+	{
+		curr->wakeup_tick = wakeup_tick;
+		list_push_back(&sleep_list, &curr->elem);
+		update_next_tick_to_awake();
+	}
+	do_schedule(THREAD_BLOCKED);
+
+	/* Woken by either thread_wake_event() or the timer. */
+	curr->event_waiting = false;
+}
+
+/* Wakes T if it is blocked in thread_wait_event(), taking it off
+ * sleep_list if it is there.  Otherwise does nothing, so extra
+ * calls are harmless.  May be called from an interrupt handler. */
+void thread_wake_event(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (t->event_waiting && t->status == THREAD_BLOCKED)
+	{
+		t->event_waiting = false;
+		if (t->event_timed)
+		{
+			list_remove(&t->elem);
+			update_next_tick_to_awake();
+		}
+		thread_unblock(t);
+	}
+	intr_set_level(old_level);
+}
+
 /* update local tick */
 void update_next_tick_to_awake()
 {
@@ -709,9 +819,9 @@ void test_max_priority(void)
 		return;
 	}
 
-	struct list_elem *e = list_begin(&ready_list);
+	struct list_elem *e = list_begin(&ready_list.list);
 
-	if (e != list_end(&ready_list))
+	if (e != list_end(&ready_list.list))
 	{
 		struct thread *max_ready_list = list_entry(e, struct thread, elem);
 
@@ -726,9 +836,9 @@ void update_load_avg(void)
 	int new_load_avg;
 	int f = 1 << 14;
 	if (thread_current() == idle_thread)
-		new_load_avg = ((59 * load_avg) / 60) + (list_size(&ready_list) * f / 60);
+		new_load_avg = ((59 * load_avg) / 60) + (clist_size(&ready_list) * f / 60);
 	else
-		new_load_avg = ((59 * load_avg) / 60) + ((list_size(&ready_list) + 1) * f / 60);
+		new_load_avg = ((59 * load_avg) / 60) + ((clist_size(&ready_list) + 1) * f / 60);
 	load_avg = new_load_avg;
 	return;
 }
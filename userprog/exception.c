@@ -2,6 +2,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "intrinsic.h"
@@ -148,11 +149,17 @@ page_fault(struct intr_frame *f)
 	{
 		return;
 	}
-	else
+#endif
+
+	/* A bad user pointer handed to one of the primitives in
+	   userprog/uaccess.c.  Make the primitive fail. */
+	if (!user && uaccess_fixup(f))
 	{
-		exit(-1);
+		return;
 	}
 
+#ifdef VM
+	exit(-1);
 #endif
 
 	/* Count page faults. */
@@ -0,0 +1,125 @@
+#include "userprog/ioring.h"
+#include <debug.h>
+#include <limits.h>
+#include "threads/thread.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+
+/* Performs the operation described by SQE as the matching
+ * system call would, and returns its result. */
+static int64_t ioring_do(const struct ioring_sqe *sqe)
+{
+	void *addr = (void *)(uintptr_t)sqe->addr;
+
+	/* File offsets are only 32 bits wide. */
+	if (sqe->off > INT_MAX)
+	{
+		return -1;
+	}
+
+	switch (sqe->opcode)
+	{
+	case IORING_OP_NOP:
+		return 0;
+	case IORING_OP_READ:
+		if (sqe->off >= 0)
+			return pread(sqe->fd, addr, sqe->len, sqe->off);
+		return read(sqe->fd, addr, sqe->len);
+	case IORING_OP_WRITE:
+		if (sqe->off >= 0)
+			return pwrite(sqe->fd, addr, sqe->len, sqe->off);
+		return write(sqe->fd, addr, sqe->len);
+	case IORING_OP_OPEN:
+		return open(addr);
+	case IORING_OP_CLOSE:
+		close(sqe->fd);
+		return 0;
+	case IORING_OP_MMAP:
+		return (int64_t)(uintptr_t)mmap(addr, sqe->len, sqe->flags != 0,
+										sqe->fd, sqe->off);
+	default:
+		return -1;
+	}
+}
+
+/* Registers RING, in the current process's memory, as its
+ * submission ring, replacing any earlier one.  Kills the process
+ * if RING is not a user address.  Returns 0. */
+int ioring_setup(struct ioring *ring)
+{
+	if (ring == NULL || !is_user_range(ring, sizeof *ring))
+	{
+		exit(-1);
+	}
+	thread_current()->ioring = ring;
+	return 0;
+}
+
+/* Performs up to TO_SUBMIT queued operations from the current
+ * process's ring, in order, posting a completion for each.
+ * Stops early if the submission queue runs dry or the completion
+ * queue fills up.  Every operation has completed by the time
+ * this returns, so there is nothing to wait for afterward.
+ * Returns the number of operations performed, or -1 if no ring
+ * is registered or its indexes are inconsistent. */
+int ioring_enter(unsigned to_submit)
+{
+	struct ioring *ring = thread_current()->ioring;
+	struct ioring_sqe sqe;
+	struct ioring_cqe cqe;
+	uint32_t sq_head, sq_tail, cq_head, cq_tail;
+	unsigned done;
+
+	if (ring == NULL)
+	{
+		return -1;
+	}
+
+	/* The process is inside this call, so it cannot move the
+	 * indexes while the kernel works from its own copies. */
+	if (!copy_from_user(&sq_head, &ring->sq_head, sizeof sq_head) ||
+		!copy_from_user(&sq_tail, &ring->sq_tail, sizeof sq_tail) ||
+		!copy_from_user(&cq_head, &ring->cq_head, sizeof cq_head) ||
+		!copy_from_user(&cq_tail, &ring->cq_tail, sizeof cq_tail))
+	{
+		exit(-1);
+	}
+	if (sq_tail - sq_head > IORING_ENTRIES ||
+		cq_tail - cq_head > IORING_ENTRIES)
+	{
+		return -1;
+	}
+
+	for (done = 0; done < to_submit; done++)
+	{
+		if (sq_head == sq_tail || cq_tail - cq_head == IORING_ENTRIES)
+		{
+			break;
+		}
+
+		/* Copy the entry first, so that an operation that writes
+		 * over the ring cannot change it halfway through. */
+		if (!copy_from_user(&sqe, &ring->sqes[sq_head % IORING_ENTRIES],
+							sizeof sqe))
+		{
+			exit(-1);
+		}
+		sq_head++;
+
+		cqe.user_data = sqe.user_data;
+		cqe.res = ioring_do(&sqe);
+		if (!copy_to_user(&ring->cqes[cq_tail % IORING_ENTRIES], &cqe,
+						  sizeof cqe))
+		{
+			exit(-1);
+		}
+		cq_tail++;
+	}
+
+	if (!copy_to_user(&ring->sq_head, &sq_head, sizeof sq_head) ||
+		!copy_to_user(&ring->cq_tail, &cq_tail, sizeof cq_tail))
+	{
+		exit(-1);
+	}
+	return done;
+}
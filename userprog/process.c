@@ -10,9 +10,11 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -26,6 +28,19 @@ static void process_cleanup(void);
 static bool load(const char *file_name, struct intr_frame *if_);
 static void initd(void *f_name);
 static void __do_fork(void *);
+static void __do_vfork(void *);
+static void __do_spawn(void *);
+static void vfork_release(struct thread *t);
+static int exec_packed(char *page, const char *file_name, const char *args,
+					   size_t size, int argc);
+static bool fd_table_grow(struct thread *t, int min_cap);
+static bool fd_table_copy(struct thread *dst, struct thread *src);
+static bool fd_install(struct thread *t, int fd, struct file *f);
+static bool fd_open_console(struct thread *t);
+static int pack_args(char *cmdline, size_t *size);
+
+/* Number of 64-bit words in the fd_map of a CAP-slot fd table. */
+#define FD_MAP_WORDS(cap) DIV_ROUND_UP(cap, 64)
 
 /* General process initializer for initd and other process. */
 static void
@@ -74,7 +89,7 @@ initd(void *f_name)
 
 	process_init();
 
-	if (process_exec(f_name) < 0)
+	if (!fd_open_console(thread_current()) || process_exec(f_name) < 0)
 		PANIC("Fail to launch initd\n");
 	NOT_REACHED();
 }
@@ -194,22 +209,15 @@ __do_fork(void *aux)
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
-	if (parent->fd_idx == FD_MAX)
+	if (parent->fd_cnt >= FD_MAX)
 	{
 		goto error;
 	}
+	if (!fd_table_copy(current, parent))
+		goto error;
 
-	for (int i = 2; i < FD_MAX; i++)
-	{
-		struct file *file = parent->fd_table[i];
-		if (file == NULL)
-			continue;
-		// if 'file' is already duplicated in child don't duplicate again but share it
-
-		file = file_duplicate(file);
-		current->fd_table[i] = file;
-	}
-	current->fd_idx = parent->fd_idx;
+	/* The ring itself was copied along with the address space. */
+	current->ioring = parent->ioring;
 
 	sema_up(&current->fork_sema);
 	process_init();
@@ -225,11 +233,230 @@ error:
 	exit(TID_ERROR);
 }
 
+/* Passed from process_vfork() to __do_vfork(). */
+struct vfork_info
+{
+	struct thread *parent; /* The parent, blocked in process_vfork(). */
+	bool success;		   /* Set once the child is ready to run. */
+};
+
+/* Creates a child of the current process, as `name`, that runs in
+ * the current process's address space instead of a copy of it.
+ * The child returns from the system call first, with the parent
+ * blocked until the child execs or exits and gives the address
+ * space back.  Until then the child may do little more than call
+ * exec() or exit(): anything it writes to memory, including its
+ * stack, the parent sees too.  Open files are duplicated as by
+ * fork().  Returns the child's thread id, or TID_ERROR if the
+ * child cannot be created. */
+tid_t process_vfork(const char *name, struct intr_frame *if_)
+{
+	struct thread *curr = thread_current();
+	struct vfork_info info = {curr, false};
+	struct thread *child;
+	tid_t tid;
+
+	memcpy(&curr->parent_if, if_, sizeof(struct intr_frame));
+	tid = thread_create(name, PRI_DEFAULT, __do_vfork, &info);
+	if (tid == TID_ERROR)
+		return TID_ERROR;
+	child = get_child_with_pid(tid);
+	sema_down(&child->fork_sema);
+	return info.success ? tid : TID_ERROR;
+}
+
+/* Thread function for process_vfork(): borrows the parent's
+ * address space and returns to user mode in it. */
+static void
+__do_vfork(void *info_)
+{
+	struct vfork_info *info = info_;
+	struct thread *parent = info->parent;
+	struct thread *current = thread_current();
+	struct intr_frame if_;
+
+	memcpy(&if_, &parent->parent_if, sizeof(struct intr_frame));
+	if_.R.rax = 0;
+
+	current->vfork_parent = parent;
+	current->pml4 = parent->pml4;
+#ifdef VM
+	current->spt = parent->spt;
+	current->stack_bottom = parent->stack_bottom;
+#endif
+	current->ioring = parent->ioring;
+	process_activate(current);
+
+	if (!fd_table_copy(current, parent))
+	{
+		current->exit_status = TID_ERROR;
+		exit(TID_ERROR);
+	}
+
+	process_init();
+	info->success = true;
+	do_iret(&if_);
+}
+
+/* Gives the address space that T borrowed with vfork() back to
+ * its parent and lets the parent continue.  T is left with no
+ * address space of its own. */
+static void
+vfork_release(struct thread *t)
+{
+#ifdef VM
+	struct thread *parent = t->vfork_parent;
+
+	/* Pages the child faulted in or added, such as stack, now
+	 * belong to the parent. */
+	parent->spt = t->spt;
+	parent->stack_bottom = t->stack_bottom;
+	supplemental_page_table_init(&t->spt);
+#endif
+	t->vfork_parent = NULL;
+
+	/* Stop using the page table before the parent can run and
+	 * perhaps destroy it. */
+	t->pml4 = NULL;
+	pml4_activate(NULL);
+	sema_up(&t->fork_sema);
+}
+
+/* Passed from process_spawn() to __do_spawn(). */
+struct spawn_info
+{
+	char *page;							 /* Page holding the strings below. */
+	const char *args;					 /* Arguments, packed as by pack_args(). */
+	size_t args_size;					 /* Bytes occupied by args. */
+	int argc;							 /* Number of arguments. */
+	int fd_cnt;							 /* Number of files to inherit. */
+	struct file *files[SPAWN_FD_MAX]; /* Files to inherit... */
+	int fds[SPAWN_FD_MAX];				 /* ...and their fds in the child. */
+};
+
+/* Starts a new child process running the program named at the
+ * start of PAGE, a page from palloc_get_page().  The program's
+ * ARGC arguments are packed, as by pack_args(), into the SIZE
+ * bytes at ARGS, which also lies in PAGE.  The child inherits
+ * only the console and, for each of the FD_CNT elements of FDS,
+ * a duplicate of the current process's file `fd' as its file
+ * `newfd'.  Nothing else of the current process is copied, and
+ * the current process does not wait for the child to load.
+ *
+ * Takes ownership of PAGE.  Returns the child's thread id, or
+ * TID_ERROR if an fd is invalid or the child cannot be created.
+ * A child that cannot load its program exits with status -1. */
+tid_t process_spawn(char *page, const char *args, size_t size, int argc,
+					const struct spawn_fd *fds, int fd_cnt)
+{
+	struct spawn_info *info;
+	tid_t tid = TID_ERROR;
+	int i, j;
+
+	ASSERT(fd_cnt <= SPAWN_FD_MAX);
+
+	info = malloc(sizeof *info);
+	if (info == NULL)
+	{
+		palloc_free_page(page);
+		return TID_ERROR;
+	}
+	info->page = page;
+	info->args = args;
+	info->args_size = size;
+	info->argc = argc;
+	info->fd_cnt = 0;
+
+	for (i = 0; i < fd_cnt; i++)
+	{
+		struct file *file = process_get_file(fds[i].fd);
+
+		if (file == NULL || fds[i].newfd < 0 || fds[i].newfd >= FD_MAX)
+			goto done;
+		for (j = 0; j < i; j++)
+			if (fds[j].newfd == fds[i].newfd)
+				goto done;
+		file = file_duplicate(file);
+		if (file == NULL)
+			goto done;
+		info->files[info->fd_cnt] = file;
+		info->fds[info->fd_cnt++] = fds[i].newfd;
+	}
+
+	tid = thread_create(page, PRI_DEFAULT, __do_spawn, info);
+
+done:
+	if (tid == TID_ERROR)
+	{
+		for (i = 0; i < info->fd_cnt; i++)
+			file_close(info->files[i]);
+		palloc_free_page(page);
+		free(info);
+	}
+	return tid;
+}
+
+/* Thread function for process_spawn(): sets up the files the
+ * child inherits and executes its program. */
+static void
+__do_spawn(void *info_)
+{
+	struct spawn_info *info = info_;
+	struct thread *current = thread_current();
+	char *page = info->page;
+	const char *args = info->args;
+	size_t size = info->args_size;
+	int argc = info->argc;
+	bool success = true;
+	int i;
+
+#ifdef VM
+	supplemental_page_table_init(&current->spt);
+#endif
+	process_init();
+
+	success = fd_open_console(current);
+	for (i = 0; i < info->fd_cnt; i++)
+	{
+		/* An inherited fd 0 or 1 takes the console's place. */
+		process_close_file(info->fds[i]);
+		if (!success || !fd_install(current, info->fds[i], info->files[i]))
+		{
+			file_close(info->files[i]);
+			success = false;
+		}
+	}
+	free(info);
+
+	if (success)
+		exec_packed(page, page, args, size, argc);
+	else
+		palloc_free_page(page);
+	exit(-1);
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int process_exec(void *f_name)
 {
 	char *file_name = f_name;
+	size_t args_size;
+	int argc;
+
+	/* Split the command line into its arguments, the first of
+	 * which is the program to run. */
+	argc = pack_args(file_name, &args_size);
+	return exec_packed(file_name, file_name, file_name, args_size, argc);
+}
+
+/* Switches the current execution context to program FILE_NAME,
+ * run with the ARGC arguments packed, as by pack_args(), into the
+ * SIZE bytes at ARGS.  Frees PAGE, the page from palloc_get_page()
+ * that holds them.  Returns -1 on fail. */
+static int
+exec_packed(char *page, const char *file_name, const char *args,
+			size_t size, int argc)
+{
 	bool success;
 
 	/* We cannot use the intr_frame in the thread structure.
@@ -242,40 +469,47 @@ int process_exec(void *f_name)
 
 	/* We first kill the current context */
 	process_cleanup();
-
-	char *argv[64];
-	int argc = 0;
-	char *token, *save_ptr;
-
-	token = strtok_r(file_name, " ", &save_ptr);
-	while (token != NULL)
-	{
-		argv[argc] = token;
-		token = strtok_r(NULL, " ", &save_ptr);
-		argc++;
-	}
+	thread_current()->ioring = NULL;
+	file_close(thread_current()->running);
+	thread_current()->running = NULL;
 
 	/* And then load the binary */
-	success = load(file_name, &_if);
+	success = load(file_name, &_if) && argument_stack(args, size, argc, &_if);
+
+	palloc_free_page(page);
 
 	/* If load failed, quit. */
 	if (!success)
-	{
-		palloc_free_page(file_name);
 		return -1;
-	}
-	void **rspp = &_if.rsp;
-	argument_stack(argv, argc, rspp);
-	_if.R.rdi = argc;
-	_if.R.rsi = (uint64_t)*rspp + sizeof(void *);
-
-	palloc_free_page(file_name);
 
 	/* Start switched process. */
 	do_iret(&_if);
 	NOT_REACHED();
 }
 
+/* Splits CMDLINE in place into its space-separated words, and
+ * packs them one after another at its start, each with its null
+ * terminator, ready to be copied onto the user stack in one
+ * piece.  Stores the number of bytes they occupy in *SIZE and
+ * returns the number of words. */
+static int
+pack_args(char *cmdline, size_t *size)
+{
+	char *token, *save_ptr, *end = cmdline;
+	int argc = 0;
+
+	for (token = strtok_r(cmdline, " ", &save_ptr); token != NULL;
+		 token = strtok_r(NULL, " ", &save_ptr))
+	{
+		size_t len = strlen(token) + 1;
+		memmove(end, token, len);
+		end += len;
+		argc++;
+	}
+	*size = end - cmdline;
+	return argc;
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
  * it was terminated by the kernel (i.e. killed due to an
  * exception), returns -1.  If TID is invalid or if it was not a
@@ -317,20 +551,35 @@ void process_exit(void)
 	 * TODO: Implement process termination message (see
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
-	int idx = curr->fd_idx - 1;
-	for (idx; idx >= 0; idx--)
+	for (int w = 0; w < FD_MAP_WORDS(curr->fd_cap); w++)
 	{
-		file_close(curr->fd_table[idx]);
-		curr->fd_table[idx] = NULL;
+		uint64_t used = curr->fd_map[w];
+		while (used != 0)
+		{
+			int fd = w * 64 + __builtin_ctzll(used);
+			used &= used - 1;
+			file_close(curr->fd_table[fd]);
+		}
 	}
 
 	// for multi-oom(메모리 누수)
-	palloc_free_multiple(curr->fd_table, 3);
-	// for rox- (실행중에 수정 못하도록)
-	file_close(curr->running);
-
+	if (curr->fd_table != curr->fd_inline)
+	{
+		free(curr->fd_table);
+		free(curr->fd_map);
+	}
+	curr->fd_table = curr->fd_inline;
+	curr->fd_map = &curr->fd_inline_map;
+	curr->fd_cap = FD_INLINE;
+	curr->fd_inline_map = 0;
+	curr->fd_cnt = 0;
 	process_cleanup(); // pml4를 날림(이 함수를 call 한 thread의 pml4)
 
+	/* Allow writes to the executable only now that the process's
+	 * shared text frames are released, as in exec_packed(). */
+	file_close(curr->running);
+	curr->running = NULL;
+
 	sema_up(&curr->wait_sema);	 // 종료되었다고 기다리고 있는 부모 thread에게 signal 보냄-> sema_up에서 val을 올려줌
 	sema_down(&curr->free_sema); // 부모의 exit_Status가 정확히 전달되었는지 확인(wait)
 }
@@ -341,6 +590,13 @@ process_cleanup(void)
 {
 	struct thread *curr = thread_current();
 
+	/* A vfork() child has nothing of its own to free. */
+	if (curr->vfork_parent != NULL)
+	{
+		vfork_release(curr);
+		return;
+	}
+
 #ifdef VM
 	supplemental_page_table_kill(&curr->spt);
 #endif
@@ -430,8 +686,31 @@ struct ELF64_PHDR
 #define ELF ELF64_hdr
 #define Phdr ELF64_PHDR
 
+/* A loadable segment, already validated and converted into the
+ * arguments for load_segment(). */
+struct exec_segment
+{
+	uint64_t file_page;	 /* Page-aligned offset in the file. */
+	uint64_t mem_page;	 /* Page-aligned user virtual address. */
+	uint32_t read_bytes; /* Bytes to read from the file. */
+	uint32_t zero_bytes; /* Bytes to zero after them. */
+	bool writable;		 /* Whether the pages are writable. */
+};
+
+/* What load() needs from an executable, parsed and validated
+ * once and then cached on the executable's inode, so that later
+ * loads of the same program read neither its ELF header nor its
+ * program headers. */
+struct exec_layout
+{
+	uint64_t entry;				   /* Entry point. */
+	int seg_cnt;				   /* Number of elements in seg. */
+	struct exec_segment seg[]; /* Loadable segments, in file order. */
+};
+
 static bool setup_stack(struct intr_frame *if_);
 static bool validate_segment(const struct Phdr *, struct file *);
+static struct exec_layout *parse_layout(struct file *file);
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
 						 uint32_t read_bytes, uint32_t zero_bytes,
 						 bool writable);
@@ -444,9 +723,8 @@ static bool
 load(const char *file_name, struct intr_frame *if_)
 {
 	struct thread *t = thread_current();
-	struct ELF ehdr;
+	struct exec_layout *layout;
 	struct file *file = NULL;
-	off_t file_ofs;
 	bool success = false;
 	int i;
 
@@ -456,37 +734,95 @@ load(const char *file_name, struct intr_frame *if_)
 		goto done;
 	process_activate(thread_current());
 
-	/* Open executable file. */
+	/* Open executable file.  Writes are denied from the start, so
+	 * that the layout cached on its inode cannot change while it
+	 * is in use.  The file stays open until exit even if loading
+	 * fails, because pages already set up may refer to it. */
 	file = filesys_open(file_name);
-	// file_deny_write(file);
 	if (file == NULL)
 	{
 		printf("load: %s: open failed\n", file_name);
 		goto done;
 	}
+	file_deny_write(file);
+	t->running = file;
 
-	/* Read and verify executable header. */
-	if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E // amd64
-		|| ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024)
+	/* Find the executable's layout, parsing it on first use. */
+	layout = inode_get_exec_layout(file_get_inode(file));
+	if (layout == NULL)
 	{
-		printf("load: %s: error loading executable\n", file_name);
-		goto done;
+		layout = parse_layout(file);
+		if (layout == NULL)
+		{
+			printf("load: %s: error loading executable\n", file_name);
+			goto done;
+		}
+		layout = inode_set_exec_layout(file_get_inode(file), layout);
 	}
 
-	/* Read program headers. */
-	file_ofs = ehdr.e_phoff;
-	for (i = 0; i < ehdr.e_phnum; i++)
+	/* Map its segments. */
+	for (i = 0; i < layout->seg_cnt; i++)
 	{
-		struct Phdr phdr;
+		const struct exec_segment *seg = &layout->seg[i];
 
-		if (file_ofs < 0 || file_ofs > file_length(file))
+		if (!load_segment(file, seg->file_page, (void *)seg->mem_page,
+						  seg->read_bytes, seg->zero_bytes, seg->writable))
 			goto done;
-		file_seek(file, file_ofs);
+	}
 
-		if (file_read(file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
-		file_ofs += sizeof phdr;
-		switch (phdr.p_type)
+	/* Set up stack. */
+	if (!setup_stack(if_))
+		goto done;
+
+	/* Start address. */
+	if_->rip = layout->entry;
+
+	success = true;
+
+done:
+	/* We arrive here whether the load is successful or not. */
+	return success;
+}
+
+/* Reads and validates the ELF header and program headers of
+ * executable FILE.  The program header table is read with a
+ * single file_read_at().  Returns the resulting layout, which the
+ * caller must free(), or a null pointer if FILE is not a valid
+ * executable or memory is not available. */
+static struct exec_layout *
+parse_layout(struct file *file)
+{
+	struct ELF ehdr;
+	struct Phdr *phdrs = NULL;
+	struct exec_layout *layout = NULL;
+	size_t phdrs_size;
+	int i;
+
+	/* Read and verify executable header. */
+	if (file_read_at(file, &ehdr, sizeof ehdr, 0) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E // amd64
+		|| ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024)
+		goto fail;
+
+	/* Read program headers, all at once. */
+	phdrs_size = ehdr.e_phnum * sizeof *phdrs;
+	if (ehdr.e_phoff > (uint64_t)file_length(file) || phdrs_size > file_length(file) - ehdr.e_phoff)
+		goto fail;
+	phdrs = malloc(phdrs_size);
+	layout = malloc(sizeof *layout + ehdr.e_phnum * sizeof *layout->seg);
+	if (phdrs == NULL || layout == NULL)
+		goto fail;
+	if (file_read_at(file, phdrs, phdrs_size, ehdr.e_phoff) != (off_t)phdrs_size)
+		goto fail;
+
+	layout->entry = ehdr.e_entry;
+	layout->seg_cnt = 0;
+	for (i = 0; i < ehdr.e_phnum; i++)
+	{
+		const struct Phdr *phdr = &phdrs[i];
+		struct exec_segment *seg;
+		uint64_t page_offset;
+
+		switch (phdr->p_type)
 		{
 		case PT_NULL:
 		case PT_NOTE:
@@ -498,55 +834,39 @@ load(const char *file_name, struct intr_frame *if_)
 		case PT_DYNAMIC:
 		case PT_INTERP:
 		case PT_SHLIB:
-			goto done;
+			goto fail;
 		case PT_LOAD:
-			if (validate_segment(&phdr, file))
+			if (!validate_segment(phdr, file))
+				goto fail;
+			seg = &layout->seg[layout->seg_cnt++];
+			seg->writable = (phdr->p_flags & PF_W) != 0;
+			seg->file_page = phdr->p_offset & ~PGMASK;
+			seg->mem_page = phdr->p_vaddr & ~PGMASK;
+			page_offset = phdr->p_vaddr & PGMASK;
+			if (phdr->p_filesz > 0)
 			{
-				bool writable = (phdr.p_flags & PF_W) != 0;
-				uint64_t file_page = phdr.p_offset & ~PGMASK;
-				uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
-				uint64_t page_offset = phdr.p_vaddr & PGMASK;
-				uint32_t read_bytes, zero_bytes;
-				if (phdr.p_filesz > 0)
-				{
-					/* Normal segment.
-					 * Read initial part from disk and zero the rest. */
-					read_bytes = page_offset + phdr.p_filesz;
-					zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) - read_bytes);
-				}
-				else
-				{
-					/* Entirely zero.
-					 * Don't read anything from disk. */
-					read_bytes = 0;
-					zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
-				}
-				if (!load_segment(file, file_page, (void *)mem_page,
-								  read_bytes, zero_bytes, writable))
-					goto done;
+				/* Normal segment.
+				 * Read initial part from disk and zero the rest. */
+				seg->read_bytes = page_offset + phdr->p_filesz;
+				seg->zero_bytes = (ROUND_UP(page_offset + phdr->p_memsz, PGSIZE) - seg->read_bytes);
 			}
 			else
-				goto done;
+			{
+				/* Entirely zero.
+				 * Don't read anything from disk. */
+				seg->read_bytes = 0;
+				seg->zero_bytes = ROUND_UP(page_offset + phdr->p_memsz, PGSIZE);
+			}
 			break;
 		}
 	}
-	/* Set up stack. */
-	if (!setup_stack(if_))
-		goto done;
-
-	/* Start address. */
-	if_->rip = ehdr.e_entry;
-
-	/* TODO: Your code goes here.
-	 * TODO: Implement argument passing (see project2/argument_passing.html). */
-	t->running = file;
-	file_deny_write(file);
+	free(phdrs);
+	return layout;
 
-	success = true;
-
-done:
-	/* We arrive here whether the load is successful or not. */
-	return success;
+fail:
+	free(phdrs);
+	free(layout);
+	return NULL;
 }
 
 /* Checks whether PHDR describes a valid, loadable segment in
@@ -723,7 +1043,7 @@ lazy_load_segment(struct page *page, void *aux)
 	if (file_read(file, kpage, page_read_bytes) != (int)page_read_bytes)
 	{
 		palloc_free_page(kpage);
-		free(lazy_load_arg);
+		aux_val_free(lazy_load_arg);
 		return false;
 	}
 	memset(kpage + page_read_bytes, 0, page_zero_bytes);
@@ -762,12 +1082,14 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct aux_val *lazy_load_arg = (struct aux_val *)malloc(sizeof(struct aux_val));
+		struct aux_val *lazy_load_arg = aux_val_alloc();
 		lazy_load_arg->file = file;
 		lazy_load_arg->offset = ofs;
 		lazy_load_arg->read_bytes = page_read_bytes;
 
-		if (!vm_alloc_page_with_initializer(VM_ANON, upage,
+		/* Read-only pages are shared with other processes running
+		 * the same executable; see vm/text.c. */
+		if (!vm_alloc_page_with_initializer(writable ? VM_ANON : VM_TEXT, upage,
 											writable, lazy_load_segment, lazy_load_arg))
 			return false;
 
@@ -804,49 +1126,176 @@ setup_stack(struct intr_frame *if_)
 }
 #endif /* VM */
 
-/* save arguments in user stack */
-void argument_stack(char **argv, int argc, void **rsp)
+/* Builds the initial user stack below IF_'s stack pointer from
+ * the ARGC arguments packed into the SIZE bytes at ARGS, as by
+ * pack_args(): the strings, copied in one piece, then the argv
+ * array, 16-byte aligned and null-terminated, then a fake return
+ * address.  Points IF_'s stack pointer at the return address and
+ * its argument registers at argc and argv.  Returns false if the
+ * arguments do not fit in the stack's first page. */
+bool argument_stack(const char *args, size_t size, int argc,
+					struct intr_frame *if_)
 {
-	/* save argument data */
-	for (int i = argc - 1; i >= 0; i--)
+	char *strs;
+	char **argv;
+	int i;
+
+	if (size + (argc + 1) * sizeof *argv + 24 > PGSIZE)
+		return false;
+
+	/* Argument strings. */
+	strs = (char *)if_->rsp - size;
+	memcpy(strs, args, size);
+
+	/* argv[] and the fake return address. */
+	argv = (char **)(((uintptr_t)strs - (argc + 1) * sizeof *argv) & ~(uintptr_t)15);
+	for (i = 0; i < argc; i++)
 	{
-		int arg_len = strlen(argv[i]);
-		for (int j = arg_len; j >= 0; j--)
-		{
-			char arg_char = argv[i][j];
-			(*rsp)--;
-			**(char **)rsp = arg_char;
-		}
-		argv[i] = *(char **)rsp;
+		argv[i] = strs;
+		strs += strlen(strs) + 1;
+	}
+	argv[argc] = NULL;
+	argv[-1] = NULL;
+
+	if_->rsp = (uintptr_t)(argv - 1);
+	if_->R.rdi = argc;
+	if_->R.rsi = (uint64_t)argv;
+	return true;
+}
+
+/* Moves T's fd table to a new array of at least MIN_CAP slots
+ * (at most FD_MAX), doubling its size as often as needed.
+ * Returns false if memory is not available. */
+static bool
+fd_table_grow(struct thread *t, int min_cap)
+{
+	int cap = t->fd_cap;
+	while (cap < min_cap)
+		cap *= 2;
+	if (cap > FD_MAX)
+		cap = FD_MAX;
+
+	struct file **table = calloc(cap, sizeof *table);
+	uint64_t *map = calloc(FD_MAP_WORDS(cap), sizeof *map);
+	if (table == NULL || map == NULL)
+	{
+		free(table);
+		free(map);
+		return false;
+	}
+	memcpy(table, t->fd_table, t->fd_cap * sizeof *table);
+	memcpy(map, t->fd_map, FD_MAP_WORDS(t->fd_cap) * sizeof *map);
+
+	if (t->fd_table != t->fd_inline)
+	{
+		free(t->fd_table);
+		free(t->fd_map);
 	}
+	t->fd_table = table;
+	t->fd_map = map;
+	t->fd_cap = cap;
+	return true;
+}
+
+/* Gives DST, a new process, a duplicate of each file that SRC has
+ * open, under the same fds.  Fds that share a file in SRC share
+ * its duplicate in DST.  Returns false if memory is not
+ * available. */
+static bool
+fd_table_copy(struct thread *dst, struct thread *src)
+{
+	if (src->fd_cap > dst->fd_cap && !fd_table_grow(dst, src->fd_cap))
+		return false;
 
-	/* save word alignment */
-	int alignment = (int)*rsp % 8;
-	for (int k = 0; k < alignment; k++)
+	/* Duplicate only the fds that are in use. */
+	for (int w = 0; w < FD_MAP_WORDS(src->fd_cap); w++)
 	{
-		(*rsp)--;
-		**(uint8_t **)rsp = 0;
+		uint64_t used = src->fd_map[w];
+		while (used != 0)
+		{
+			int fd = w * 64 + __builtin_ctzll(used);
+			uint64_t bit = used & -used;
+			used &= used - 1;
+			struct file *file = src->fd_table[fd];
+			struct file *copy = NULL;
+
+			if (file_is_shared(file))
+				for (int prev = 0; prev < fd && copy == NULL; prev++)
+					if (src->fd_table[prev] == file)
+						copy = file_share(dst->fd_table[prev]);
+			if (copy == NULL)
+				copy = file_duplicate(file);
+			if (copy == NULL)
+				return false;
+			dst->fd_table[fd] = copy;
+			dst->fd_map[w] |= bit;
+			dst->fd_cnt++;
+		}
 	}
+	return true;
+}
+
+/* Installs F in T's table as FD, which must be free and less
+ * than FD_MAX, growing the table as needed.
+ * Returns false if memory is not available. */
+static bool
+fd_install(struct thread *t, int fd, struct file *f)
+{
+	uint64_t bit = (uint64_t)1 << (fd % 64);
+
+	ASSERT(fd >= 0 && fd < FD_MAX);
 
-	/* save argument address */
-	(*rsp) -= 8;
-	**(char ***)rsp = 0;
+	if (fd >= t->fd_cap && !fd_table_grow(t, fd + 1))
+		return false;
+	ASSERT(t->fd_table[fd] == NULL);
+	t->fd_table[fd] = f;
+	t->fd_map[fd / 64] |= bit;
+	t->fd_cnt++;
+	return true;
+}
 
-	for (int i = argc - 1; i >= 0; i--)
+/* Opens the console's input and output ends as T's fds 0 and 1,
+ * which must be free.  Returns false if memory is not available,
+ * leaving whichever end was opened installed. */
+static bool
+fd_open_console(struct thread *t)
+{
+	struct file *in = file_open_console(false);
+	if (in == NULL || !fd_install(t, 0, in))
 	{
-		(*rsp) -= 8;
-		**(char ***)rsp = argv[i];
+		file_close(in);
+		return false;
 	}
+	struct file *out = file_open_console(true);
+	if (out == NULL || !fd_install(t, 1, out))
+	{
+		file_close(out);
+		return false;
+	}
+	return true;
+}
 
-	/* save return address (fake) */
-	(*rsp) -= 8;
-	**(void ***)rsp = 0;
+/* Returns the lowest fd not in use in T's table, or -1 if the
+ * table is full. */
+static int
+fd_lowest_free(struct thread *t)
+{
+	for (int w = 0; w < FD_MAP_WORDS(t->fd_cap); w++)
+	{
+		int bits = t->fd_cap - w * 64;
+		uint64_t free_fds = ~t->fd_map[w];
+		if (bits < 64)
+			free_fds &= ((uint64_t)1 << bits) - 1;
+		if (free_fds != 0)
+			return w * 64 + __builtin_ctzll(free_fds);
+	}
+	return -1;
 }
 
 struct file *process_get_file(int fd)
 {
 	struct thread *curr = thread_current();
-	if (fd < 0 || fd >= FD_MAX)
+	if (fd < 0 || fd >= curr->fd_cap)
 	{
 		return NULL;
 	}
@@ -856,28 +1305,59 @@ struct file *process_get_file(int fd)
 int process_add_file(struct file *f)
 {
 	struct thread *curr = thread_current();
-	struct file **fdt = curr->fd_table;
+	int fd = fd_lowest_free(curr);
 
-	while (curr->fd_idx < FD_MAX && fdt[curr->fd_idx])
-	{
-		curr->fd_idx++;
-	}
-	if (curr->fd_idx >= FD_MAX)
+	if (fd < 0)
 	{
-		return -1;
+		fd = curr->fd_cap;
+		if (curr->fd_cap >= FD_MAX || !fd_table_grow(curr, curr->fd_cap + 1))
+			return -1;
 	}
-	fdt[curr->fd_idx] = f;
-	return curr->fd_idx;
+	curr->fd_table[fd] = f;
+	curr->fd_map[fd / 64] |= (uint64_t)1 << (fd % 64);
+	curr->fd_cnt++;
+	return fd;
 }
 
+/* Closes FD, if it is open, and frees it for reuse. */
 void process_close_file(int fd)
 {
 	struct thread *curr = thread_current();
+	uint64_t bit = (uint64_t)1 << (fd % 64);
 
-	if (fd < 0 || fd >= FD_MAX)
+	if (fd < 0 || fd >= curr->fd_cap || curr->fd_table[fd] == NULL)
 	{
 		return;
 	}
 	file_close(curr->fd_table[fd]);
 	curr->fd_table[fd] = NULL;
+	curr->fd_map[fd / 64] &= ~bit;
+	curr->fd_cnt--;
+}
+
+/* Makes NEWFD refer to the file that OLDFD refers to, closing
+ * NEWFD first if it is open, and returns NEWFD.  The two fds then
+ * share the file and its position, which for fds 0 and 1 may be
+ * the console.  Returns -1 if OLDFD is not an open file or NEWFD
+ * is out of range. */
+int process_dup2(int oldfd, int newfd)
+{
+	struct thread *curr = thread_current();
+	struct file *file = process_get_file(oldfd);
+
+	if (file == NULL || newfd < 0 || newfd >= FD_MAX)
+	{
+		return -1;
+	}
+	if (oldfd == newfd)
+	{
+		return newfd;
+	}
+	if (newfd >= curr->fd_cap && !fd_table_grow(curr, newfd + 1))
+	{
+		return -1;
+	}
+	process_close_file(newfd);
+	fd_install(curr, newfd, file_share(file));
+	return newfd;
 }
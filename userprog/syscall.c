@@ -1,5 +1,8 @@
 #include "userprog/syscall.h"
+#include <limits.h>
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -14,7 +17,12 @@
 #include "filesys/file.h"
 #include "threads/synch.h"
 #include "userprog/process.h"
+#include "userprog/ioring.h"
+#include "userprog/uaccess.h"
+#include "filesys/directory.h"
 #include "threads/palloc.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -22,7 +30,8 @@ void syscall_handler(struct intr_frame *);
 bool create(const char *file, unsigned initial_size);
 bool remove(const char *file);
 
-struct lock filesys_lock;
+static bool copy_in_name(char name[NAME_MAX + 1], const char *uname);
+static void check_buffer(const void *buffer, size_t size);
 
 /* System call.
  *
@@ -48,8 +57,6 @@ void syscall_init(void)
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			  FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-
-	lock_init(&filesys_lock);
 }
 
 /* The main system call interface */
@@ -100,6 +107,36 @@ void syscall_handler(struct intr_frame *f UNUSED)
 		// check_valid_buffer(f->R.rsi, f->R.rdx, f->rsp, 0);
 		f->R.rax = write(f->R.rdi, f->R.rsi, f->R.rdx);
 		break;
+	case SYS_READV:
+		f->R.rax = readv(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_WRITEV:
+		f->R.rax = writev(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_PREAD:
+		f->R.rax = pread(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_PWRITE:
+		f->R.rax = pwrite(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_COPY_FILE_RANGE:
+		f->R.rax = copy_file_range(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_SENDFILE:
+		f->R.rax = sendfile(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_VFORK:
+		f->R.rax = vfork(f);
+		break;
+	case SYS_SPAWN:
+		f->R.rax = spawn(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_IORING_SETUP:
+		f->R.rax = ioring_setup(f->R.rdi);
+		break;
+	case SYS_IORING_ENTER:
+		f->R.rax = ioring_enter(f->R.rdi);
+		break;
 	case SYS_SEEK:
 		seek(f->R.rdi, f->R.rsi);
 		break;
@@ -109,6 +146,15 @@ void syscall_handler(struct intr_frame *f UNUSED)
 	case SYS_CLOSE:
 		close(f->R.rdi);
 		break;
+	case SYS_DUP2:
+		f->R.rax = dup2(f->R.rdi, f->R.rsi);
+		break;
+	case SYS_PIPE:
+		f->R.rax = pipe(f->R.rdi);
+		break;
+	case SYS_POLL:
+		f->R.rax = poll(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
 	case SYS_MMAP:
 		f->R.rax = mmap(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8);
 		break;
@@ -136,8 +182,13 @@ void exit(int status)
 
 int open(const char *file)
 {
-	check_address(file);
-	struct file *open_file = filesys_open(file);
+	char name[NAME_MAX + 1];
+
+	if (!copy_in_name(name, file))
+	{
+		return -1;
+	}
+	struct file *open_file = filesys_open(name);
 
 	if (open_file == NULL)
 	{
@@ -162,77 +213,451 @@ int filesize(int fd)
 	return file_length(file);
 }
 
-int read(int fd, void *buffer, unsigned size)
+/* A position within an array of user buffers. */
+struct user_iov_cursor
 {
-	check_address(buffer);
-	unsigned char *buf = buffer;
-	int read_size;
-	struct thread *curr = thread_current();
+	const struct iovec *iov; /* Current buffer. */
+	size_t ofs;				 /* Offset within current buffer. */
+};
+
+/* Copies SIZE bytes between kernel buffer KBUF and the user
+ * buffers at CUR, into the user buffers if TO_USER is true and
+ * out of them otherwise, and advances CUR past them.  Returns
+ * false if a user buffer faults. */
+static bool user_iov_copy(struct user_iov_cursor *cur, void *kbuf, size_t size,
+						  bool to_user)
+{
+	uint8_t *p = kbuf;
+
+	while (size > 0)
+	{
+		while (cur->ofs == cur->iov->iov_len)
+		{
+			cur->iov++;
+			cur->ofs = 0;
+		}
 
-	if (fd == 1)
+		uint8_t *ubuf = (uint8_t *)cur->iov->iov_base + cur->ofs;
+		size_t n = cur->iov->iov_len - cur->ofs;
+		if (n > size)
+		{
+			n = size;
+		}
+		if (to_user ? !copy_to_user(ubuf, p, n) : !copy_from_user(p, ubuf, n))
+		{
+			return false;
+		}
+		p += n;
+		size -= n;
+		cur->ofs += n;
+	}
+	return true;
+}
+
+/* Most kernel pages that stage one file system call's worth of a
+ * transfer. */
+#define STAGE_PAGES 8
+
+/* Kernel pages that stage data between user buffers and a file.
+ * They are handed to the file system together, as one vector, so
+ * that a transfer of up to STAGE_PAGES pages makes one walk over
+ * the file's blocks. */
+struct stage
+{
+	struct iovec iov[STAGE_PAGES]; /* The pages, trimmed to the data. */
+	int cnt;					   /* Number of pages allocated. */
+};
+
+/* Allocates enough pages in ST for SIZE bytes, up to STAGE_PAGES,
+ * making do with fewer if memory is short.  Returns false if not
+ * even one page is available. */
+static bool stage_alloc(struct stage *st, size_t size)
+{
+	size_t want = DIV_ROUND_UP(size, PGSIZE);
+
+	if (want > STAGE_PAGES)
+	{
+		want = STAGE_PAGES;
+	}
+	for (st->cnt = 0; (size_t)st->cnt < want; st->cnt++)
+	{
+		st->iov[st->cnt].iov_base = palloc_get_page(0);
+		if (st->iov[st->cnt].iov_base == NULL)
+		{
+			break;
+		}
+	}
+	return st->cnt > 0;
+}
+
+/* Frees ST's pages. */
+static void stage_free(struct stage *st)
+{
+	int i;
+
+	for (i = 0; i < st->cnt; i++)
+	{
+		palloc_free_page(st->iov[i].iov_base);
+	}
+}
+
+/* Trims ST's pages to hold the first SIZE bytes, or as much of
+ * them as fits, and returns the number of pages that hold data.
+ * Stores the number of bytes they hold in *STAGED. */
+static int stage_trim(struct stage *st, size_t size, size_t *staged)
+{
+	int i;
+
+	*staged = 0;
+	for (i = 0; i < st->cnt && size > 0; i++)
+	{
+		st->iov[i].iov_len = size < PGSIZE ? size : PGSIZE;
+		size -= st->iov[i].iov_len;
+		*staged += st->iov[i].iov_len;
+	}
+	return i;
+}
+
+/* Copies the first SIZE bytes of ST's pages to the user buffers
+ * at CUR if TO_USER is true, and otherwise fills them from there.
+ * Returns false if a user buffer faults. */
+static bool stage_copy(struct stage *st, struct user_iov_cursor *cur,
+					   size_t size, bool to_user)
+{
+	int i;
+
+	for (i = 0; size > 0; i++)
+	{
+		size_t n = size < PGSIZE ? size : PGSIZE;
+		if (!user_iov_copy(cur, st->iov[i].iov_base, n, to_user))
+		{
+			return false;
+		}
+		size -= n;
+	}
+	return true;
+}
+
+/* Reads SIZE bytes from FILE into the user buffers in IOV, whose
+ * total length is SIZE, at position OFS, or at FILE's current
+ * position if OFS is negative.
+ *
+ * The data is staged in kernel pages, and is copied out to the
+ * process only after the file system has let go of its locks.  A
+ * bad user pointer therefore kills the process without leaving an
+ * inode or a pipe locked, and the file system and the disk driver
+ * only ever see kernel memory.  A pipe is read only once, because
+ * a second read could wait for data that the caller did not ask
+ * to wait for.  Returns the number of bytes read, or -1 if the
+ * first read fails. */
+static int read_to_user(struct file *file, const struct iovec *iov,
+						size_t size, off_t ofs)
+{
+	struct user_iov_cursor cur = {iov, 0};
+	struct stage st;
+	size_t done = 0;
+	off_t n = 0;
+
+	if (size == 0)
+	{
+		return 0;
+	}
+	if (!stage_alloc(&st, size))
 	{
 		return -1;
 	}
-	else if (fd == 0)
+
+	while (done < size)
 	{
-		char key;
-		for (read_size = 0; read_size < size; read_size++)
+		size_t chunk;
+		int cnt = stage_trim(&st, size - done, &chunk);
+		n = ofs < 0 ? file_readv(file, st.iov, cnt)
+					: file_readv_at(file, st.iov, cnt, ofs + done);
+		if (n <= 0)
+		{
+			break;
+		}
+		if (!stage_copy(&st, &cur, n, true))
+		{
+			stage_free(&st);
+			exit(-1);
+		}
+		done += n;
+		if ((size_t)n < chunk || file_is_pipe(file))
 		{
-			key = input_getc();
-			*buf++ = key;
-			if (key == "\n")
-			{
-				break;
-			}
+			break;
 		}
 	}
-	else
+	stage_free(&st);
+	return n < 0 && done == 0 ? -1 : (int)done;
+}
+
+/* Writes SIZE bytes from the user buffers in IOV, whose total
+ * length is SIZE, into FILE at position OFS, or at FILE's current
+ * position if OFS is negative.
+ * Stages the data in kernel pages as read_to_user() does.
+ * Returns the number of bytes written, or -1 if the first write
+ * fails. */
+static int write_from_user(struct file *file, const struct iovec *iov,
+						   size_t size, off_t ofs)
+{
+	struct user_iov_cursor cur = {iov, 0};
+	struct stage st;
+	size_t done = 0;
+	off_t n = 0;
+
+	if (size == 0)
+	{
+		return 0;
+	}
+	if (!stage_alloc(&st, size))
+	{
+		return -1;
+	}
+
+	while (done < size)
 	{
-		struct file *file = process_get_file(fd);
-		if (file == NULL)
+		size_t chunk;
+		int cnt = stage_trim(&st, size - done, &chunk);
+		if (!stage_copy(&st, &cur, chunk, false))
 		{
-			return -1;
+			stage_free(&st);
+			exit(-1);
 		}
-		lock_acquire(&filesys_lock);
-		read_size = file_read(file, buffer, size);
-		lock_release(&filesys_lock);
+		n = ofs < 0 ? file_writev(file, st.iov, cnt)
+					: file_writev_at(file, st.iov, cnt, ofs + done);
+		if (n > 0)
+		{
+			done += n;
+		}
+		if (n < (off_t)chunk)
+		{
+			break;
+		}
+	}
+	stage_free(&st);
+	return n < 0 && done == 0 ? -1 : (int)done;
+}
+
+int read(int fd, void *buffer, unsigned size)
+{
+	check_buffer(buffer, size);
+	struct iovec iov = {buffer, size};
+	struct file *file = process_get_file(fd);
+
+	if (file == NULL)
+	{
+		return -1;
 	}
-	return read_size;
+	return read_to_user(file, &iov, size, -1);
 }
 
 int write(int fd, const void *buffer, unsigned size)
 {
-	check_address(buffer);
-	int write_size;
+	check_buffer(buffer, size);
+	struct iovec iov = {(void *)buffer, size};
+	struct file *file = process_get_file(fd);
 
-	if (fd == 0)
+	if (file == NULL)
 	{
 		return -1;
 	}
-	else if (fd == 1)
+	return write_from_user(file, &iov, size, -1);
+}
+
+/* Copies the IOVCNT iovecs at UIOV into KIOV and checks that the
+ * buffers they describe lie in user memory.  Kills the process on
+ * a bad pointer.  Returns the buffers' total length, or -1 if
+ * IOVCNT is out of range or the total does not fit in an int. */
+static int copy_in_iovecs(struct iovec *kiov, const struct iovec *uiov,
+						  int iovcnt)
+{
+	size_t total = 0;
+	int i;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX)
 	{
-		putbuf(buffer, size);
-		write_size = size;
+		return -1;
 	}
-	else
+	if (iovcnt == 0)
 	{
-		struct file *file = process_get_file(fd);
-		if (file == NULL)
+		return 0;
+	}
+	if (!copy_from_user(kiov, uiov, iovcnt * sizeof *kiov))
+	{
+		exit(-1);
+	}
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		if (kiov[i].iov_len > INT_MAX - total)
 		{
 			return -1;
 		}
-		lock_acquire(&filesys_lock);
-		write_size = file_write(file, buffer, size);
-		lock_release(&filesys_lock);
+		total += kiov[i].iov_len;
+	}
+	for (i = 0; i < iovcnt; i++)
+	{
+		if (kiov[i].iov_len > 0)
+		{
+			check_buffer(kiov[i].iov_base, kiov[i].iov_len);
+		}
 	}
-	return write_size;
+	return total;
+}
+
+int readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	struct iovec kiov[IOV_MAX];
+	int total;
+
+	total = copy_in_iovecs(kiov, iov, iovcnt);
+	if (total == -1)
+	{
+		return -1;
+	}
+
+	struct file *file = process_get_file(fd);
+	if (file == NULL)
+	{
+		return -1;
+	}
+	return read_to_user(file, kiov, total, -1);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	struct iovec kiov[IOV_MAX];
+	int total;
+
+	total = copy_in_iovecs(kiov, iov, iovcnt);
+	if (total == -1)
+	{
+		return -1;
+	}
+
+	struct file *file = process_get_file(fd);
+	if (file == NULL)
+	{
+		return -1;
+	}
+	return write_from_user(file, kiov, total, -1);
+}
+
+int pread(int fd, void *buffer, unsigned size, off_t offset)
+{
+	check_buffer(buffer, size);
+	struct iovec iov = {buffer, size};
+
+	if (offset < 0)
+	{
+		return -1;
+	}
+	struct file *file = process_get_file(fd);
+	if (file == NULL)
+	{
+		return -1;
+	}
+	return read_to_user(file, &iov, size, offset);
+}
+
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset)
+{
+	check_buffer(buffer, size);
+	struct iovec iov = {(void *)buffer, size};
+
+	if (offset < 0)
+	{
+		return -1;
+	}
+	struct file *file = process_get_file(fd);
+	if (file == NULL)
+	{
+		return -1;
+	}
+	return write_from_user(file, &iov, size, offset);
+}
+
+int copy_file_range(int fd_in, int fd_out, unsigned length)
+{
+	struct file *src = process_get_file(fd_in);
+	struct file *dst = process_get_file(fd_out);
+	if (src == NULL || dst == NULL)
+	{
+		return -1;
+	}
+	if (length > INT_MAX)
+	{
+		length = INT_MAX;
+	}
+
+	/* Overlapping ranges of one file would be read after they had
+	 * been partly overwritten. */
+	if (file_get_inode(src) == file_get_inode(dst))
+	{
+		int64_t src_ofs = file_tell(src);
+		int64_t dst_ofs = file_tell(dst);
+		if (src_ofs < dst_ofs + length && dst_ofs < src_ofs + length)
+		{
+			return -1;
+		}
+	}
+	return file_copy_range(dst, src, length);
+}
+
+int sendfile(int fd_out, int fd_in, unsigned length)
+{
+	struct file *src = process_get_file(fd_in);
+	struct file *dst = process_get_file(fd_out);
+	if (src == NULL || dst == NULL)
+	{
+		return -1;
+	}
+	if (file_get_inode(dst) != NULL)
+	{
+		return copy_file_range(fd_in, fd_out, length);
+	}
+
+	/* To the console or a pipe, a page at a time.  Reads that start
+	 * on a sector boundary land in the page straight from disk. */
+	char *buffer = palloc_get_page(0);
+	if (buffer == NULL)
+	{
+		return -1;
+	}
+	if (length > INT_MAX)
+	{
+		length = INT_MAX;
+	}
+
+	unsigned sent = 0;
+	while (sent < length)
+	{
+		off_t chunk_size = length - sent < PGSIZE ? length - sent : PGSIZE;
+		off_t bytes_read = file_read(src, buffer, chunk_size);
+		if (bytes_read <= 0)
+		{
+			break;
+		}
+		off_t bytes_written = file_write(dst, buffer, bytes_read);
+		if (bytes_written > 0)
+		{
+			sent += bytes_written;
+		}
+		if (bytes_written < bytes_read)
+		{
+			break;
+		}
+	}
+	palloc_free_page(buffer);
+	return sent;
 }
 
 void seek(int fd, unsigned position)
 {
 	struct file *file = process_get_file(fd);
 
-	if (fd < 2)
+	if (file == NULL)
 	{
 		return;
 	}
@@ -243,7 +668,7 @@ unsigned tell(int fd)
 {
 	struct file *file = process_get_file(fd);
 
-	if (fd < 2)
+	if (file == NULL)
 	{
 		return;
 	}
@@ -261,28 +686,170 @@ void close(int fd)
 	process_close_file(fd);
 }
 
+int dup2(int oldfd, int newfd)
+{
+	return process_dup2(oldfd, newfd);
+}
+
+/* Creates a pipe and stores fds for its read end and its write
+ * end in FDS[0] and FDS[1].  Returns 0 if successful, -1 if the
+ * pipe or its fds cannot be allocated. */
+int pipe(int *fds)
+{
+	struct file *read_end, *write_end;
+	int kfds[2];
+
+	if (!file_open_pipe(&read_end, &write_end))
+	{
+		return -1;
+	}
+	kfds[0] = process_add_file(read_end);
+	kfds[1] = kfds[0] == -1 ? -1 : process_add_file(write_end);
+	if (kfds[1] == -1)
+	{
+		if (kfds[0] == -1)
+			file_close(read_end);
+		else
+			process_close_file(kfds[0]);
+		file_close(write_end);
+		return -1;
+	}
+
+	/* Exiting closes both ends. */
+	if (!copy_to_user(fds, kfds, sizeof kfds))
+	{
+		exit(-1);
+	}
+	return 0;
+}
+
+/* Returns the events that hold for PFD's file descriptor, among
+ * those it asks for and the ones always reported.  If ENTRY is not
+ * null, adds it to the wait queue that reports changes, if the
+ * descriptor has one. */
+static short poll_fd(const struct pollfd *pfd, struct waitq_entry *entry)
+{
+	struct file *file;
+
+	if (pfd->fd < 0)
+	{
+		return 0;
+	}
+	file = process_get_file(pfd->fd);
+	if (file == NULL)
+		return POLLNVAL;
+	return file_poll(file, entry) & (pfd->events | POLLERR | POLLHUP);
+}
+
+/* Waits until at least one of the NFDS entries in FDS is ready
+ * for one of its events, or for TIMEOUT milliseconds, and sets
+ * every entry's `revents'.  A negative TIMEOUT waits indefinitely
+ * and 0 does not wait at all.  Returns the number of entries with
+ * nonzero `revents', which is 0 on timeout, or -1 if NFDS is more
+ * than POLL_MAX or memory is short.
+ *
+ * The first scan adds the thread to the wait queue of every pipe
+ * end and of the console input that it looks at.  Until something
+ * is ready, the thread then sleeps, using no CPU, until one of
+ * those or the timer wakes it, and scans again.  Interrupts stay
+ * off from each scan into the sleep after it, so that no wakeup
+ * can fall between the two. */
+int poll(struct pollfd *ufds, unsigned nfds, int timeout)
+{
+	struct pollfd *fds;
+	struct waitq_entry *entries;
+	enum intr_level old_level;
+	int64_t deadline = -1;
+	bool first = true;
+	int ready;
+	unsigned i;
+
+	if (nfds > POLL_MAX)
+	{
+		return -1;
+	}
+	fds = malloc(nfds * sizeof *fds);
+	entries = malloc(nfds * sizeof *entries);
+	if (nfds > 0 && (fds == NULL || entries == NULL))
+	{
+		free(fds);
+		free(entries);
+		return -1;
+	}
+	if (!copy_from_user(fds, ufds, nfds * sizeof *fds))
+	{
+		free(fds);
+		free(entries);
+		exit(-1);
+	}
+	for (i = 0; i < nfds; i++)
+		entries[i].queue = NULL;
+
+	if (timeout > 0)
+		deadline = timer_ticks() + ((int64_t)timeout * TIMER_FREQ + 999) / 1000;
+
+	old_level = intr_disable();
+	for (;;)
+	{
+		ready = 0;
+		for (i = 0; i < nfds; i++)
+		{
+			fds[i].revents = poll_fd(&fds[i], first ? &entries[i] : NULL);
+			if (fds[i].revents != 0)
+				ready++;
+		}
+		first = false;
+
+		if (ready > 0 || timeout == 0 || (deadline >= 0 && timer_ticks() >= deadline))
+			break;
+		thread_wait_event(deadline);
+	}
+	intr_set_level(old_level);
+
+	for (i = 0; i < nfds; i++)
+		waitq_remove(&entries[i]);
+	free(entries);
+	if (!copy_to_user(ufds, fds, nfds * sizeof *fds))
+	{
+		free(fds);
+		exit(-1);
+	}
+	free(fds);
+	return ready;
+}
+
 bool create(const char *file, unsigned initial_size)
 {
-	check_address(file);
-	return filesys_create(file, initial_size);
+	char name[NAME_MAX + 1];
+
+	return copy_in_name(name, file) && filesys_create(name, initial_size);
 }
 
 bool remove(const char *file)
 {
-	check_address(file);
-	return filesys_remove(file);
+	char name[NAME_MAX + 1];
+
+	return copy_in_name(name, file) && filesys_remove(name);
 }
 
 int exec(char *file_name)
 {
-	check_address(file_name);
-	int file_size = strlen(file_name) + 1;
-	char *fn_copy = palloc_get_page(PAL_ZERO);
+	char *fn_copy = palloc_get_page(0);
 	if (fn_copy == NULL)
 	{
 		exit(-1);
 	}
-	strlcpy(fn_copy, file_name, file_size); // file 이름만 복사
+	int len = strncpy_from_user(fn_copy, file_name, PGSIZE);
+	if (len == -1)
+	{
+		palloc_free_page(fn_copy);
+		exit(-1);
+	}
+	if (len >= PGSIZE)
+	{
+		palloc_free_page(fn_copy);
+		return -1;
+	}
 	if (process_exec(fn_copy) == -1)
 	{
 		return -1;
@@ -293,7 +860,85 @@ int exec(char *file_name)
 
 tid_t fork(const char *thread_name, struct intr_frame *f)
 {
-	return process_fork(thread_name, f);
+	char name[sizeof thread_current()->name];
+
+	/* Longer names are cut short, as thread_create() would. */
+	if (strncpy_from_user(name, thread_name, sizeof name) == -1)
+	{
+		exit(-1);
+	}
+	name[sizeof name - 1] = '\0';
+	return process_fork(name, f);
+}
+
+tid_t vfork(struct intr_frame *f)
+{
+	return process_vfork(thread_name(), f);
+}
+
+/* Starts program FILE in a new process, with the null-terminated
+ * argument vector ARGV, or with FILE as its only argument if ARGV
+ * is null, and the FD_CNT files described by FDS.  Returns the
+ * new process's pid, or -1 if it cannot be created. */
+tid_t spawn(const char *file, char *const argv[],
+			const struct spawn_fd *fds, int fd_cnt)
+{
+	struct spawn_fd kfds[SPAWN_FD_MAX];
+	const char *arg;
+	char *page;
+	size_t ofs, args_ofs;
+	int len, argc;
+
+	if (fd_cnt < 0 || fd_cnt > SPAWN_FD_MAX)
+	{
+		return -1;
+	}
+	if (!copy_from_user(kfds, fds, fd_cnt * sizeof *kfds))
+	{
+		exit(-1);
+	}
+
+	page = palloc_get_page(0);
+	if (page == NULL)
+	{
+		return -1;
+	}
+
+	/* The program's name, then its arguments packed one after
+	 * another, as process_exec() would have packed them. */
+	len = strncpy_from_user(page, file, PGSIZE);
+	if (len == -1)
+		goto bad_ptr;
+	if (len >= PGSIZE)
+		goto fail;
+	ofs = args_ofs = len + 1;
+	for (argc = 0;; argc++)
+	{
+		if (argv == NULL)
+			arg = argc == 0 ? file : NULL;
+		else if (!copy_from_user(&arg, argv + argc, sizeof arg))
+			goto bad_ptr;
+		if (arg == NULL)
+			break;
+		if (ofs >= PGSIZE)
+			goto fail;
+		len = strncpy_from_user(page + ofs, arg, PGSIZE - ofs);
+		if (len == -1)
+			goto bad_ptr;
+		if ((size_t)len >= PGSIZE - ofs)
+			goto fail;
+		ofs += len + 1;
+	}
+	return process_spawn(page, page + args_ofs, ofs - args_ofs, argc, kfds,
+						 fd_cnt);
+
+fail:
+	palloc_free_page(page);
+	return -1;
+
+bad_ptr:
+	palloc_free_page(page);
+	exit(-1);
 }
 
 int wait(tid_t pid)
@@ -301,9 +946,26 @@ int wait(tid_t pid)
 	process_wait(pid);
 }
 
-void check_address(void *addr)
+/* Copies the file name at user address UNAME into NAME.  Kills
+ * the process on a bad pointer.  Returns false if the name is too
+ * long to name any file. */
+static bool copy_in_name(char name[NAME_MAX + 1], const char *uname)
 {
-	if (is_kernel_vaddr(addr) || !(addr))
+	int len = strncpy_from_user(name, uname, NAME_MAX + 1);
+
+	if (len == -1)
+	{
+		exit(-1);
+	}
+	return len <= NAME_MAX;
+}
+
+/* Kills the process unless the SIZE bytes at BUFFER lie in user
+ * memory.  Whether they are mapped is found out when they are
+ * copied, which fails the system call cleanly if they are not. */
+static void check_buffer(const void *buffer, size_t size)
+{
+	if (buffer == NULL || !is_user_range(buffer, size))
 	{
 		exit(-1);
 	}
@@ -319,9 +981,6 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	if (pg_round_down(addr) != addr || is_kernel_vaddr(addr) || addr == NULL || (long long)length <= 0)
 		return NULL;
 
-	if (fd == 0 || fd == 1)
-		exit(-1);
-
 	if (spt_find_page(&thread_current()->spt, addr))
 		return NULL;
 
@@ -0,0 +1,154 @@
+#include "userprog/uaccess.h"
+#include <limits.h>
+
+/* Access to user memory from the kernel.
+ *
+ * A system call argument that points into user memory is not
+ * checked page by page before it is used.  The primitives below
+ * only check that the range lies below KERN_BASE, which is
+ * arithmetic, and then touch it.  Every instruction in them that
+ * can fault on a user address is listed in the exception table,
+ * together with an address to resume at.  If such an instruction
+ * faults and the page fault handler cannot bring the page in,
+ * page_fault() calls uaccess_fixup(), which sends the thread to
+ * the resume address, and the primitive reports failure to its
+ * caller instead of the fault killing the process.  A bad pointer
+ * therefore costs nothing until it is actually used, and then
+ * fails the system call at a point where it holds no locks. */
+
+/* An exception table entry: a fault at `insn' resumes at
+ * `fixup'. */
+struct exception_entry
+{
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+/* The exception table, gathered from the __ex_table sections by
+ * threads/kernel.lds.S. */
+extern const struct exception_entry __start_ex_table[];
+extern const struct exception_entry __stop_ex_table[];
+
+/* Adds an exception table entry saying that a fault at local
+ * label FROM resumes at local label TO. */
+#define EXTABLE(FROM, TO)              \
+	".pushsection __ex_table, \"a\"\n" \
+	".balign 8\n"                      \
+	".quad " #FROM ", " #TO "\n"       \
+	".popsection\n"
+
+/* Copies SIZE bytes from user address USRC to DST.  Returns true
+ * if successful, false if any part of the source is not readable
+ * user memory.  DST may be partly written on failure. */
+bool copy_from_user(void *dst, const void *usrc, size_t size)
+{
+	if (!is_user_range(usrc, size))
+	{
+		return false;
+	}
+
+	/* On a fault, RCX holds the number of bytes not copied. */
+	asm volatile("1: rep movsb\n"
+				 "2:\n" EXTABLE(1b, 2b)
+				 : "+D"(dst), "+S"(usrc), "+c"(size)
+				 :
+				 : "memory");
+	return size == 0;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns true
+ * if successful, false if any part of the destination is not
+ * writable user memory. */
+bool copy_to_user(void *udst, const void *src, size_t size)
+{
+	if (!is_user_range(udst, size))
+	{
+		return false;
+	}
+
+	asm volatile("1: rep movsb\n"
+				 "2:\n" EXTABLE(1b, 2b)
+				 : "+D"(udst), "+S"(src), "+c"(size)
+				 :
+				 : "memory");
+	return size == 0;
+}
+
+/* Reads the byte at user address USRC into *DST.  Returns true if
+ * successful, false if it faults. */
+static inline bool get_user_byte(char *dst, const char *usrc)
+{
+	int ok = 0;
+	char byte;
+
+	/* A fault skips setting OK. */
+	asm volatile("1: movb %2, %0\n"
+				 "   movl $1, %1\n"
+				 "2:\n" EXTABLE(1b, 2b)
+				 : "=&q"(byte), "+r"(ok)
+				 : "m"(*usrc));
+	if (ok)
+	{
+		*dst = byte;
+	}
+	return ok;
+}
+
+/* Copies the null-terminated string at user address USRC into
+ * DST, which holds SIZE bytes.  Returns the string's length, not
+ * counting the null terminator, if the string and its terminator
+ * fit in DST, or SIZE if they do not, in which case DST is not
+ * null-terminated.  Returns -1 if the string runs into memory that
+ * is not readable user memory. */
+int strncpy_from_user(char *dst, const char *usrc, size_t size)
+{
+	uintptr_t start = (uintptr_t)usrc;
+	size_t limit = size;
+	size_t i;
+
+	if (start >= KERN_BASE)
+	{
+		return -1;
+	}
+	if (limit > KERN_BASE - start)
+	{
+		limit = KERN_BASE - start;
+	}
+	if (limit > INT_MAX)
+	{
+		limit = INT_MAX;
+	}
+
+	for (i = 0; i < limit; i++)
+	{
+		if (!get_user_byte(&dst[i], &usrc[i]))
+		{
+			return -1;
+		}
+		if (dst[i] == '\0')
+		{
+			return i;
+		}
+	}
+	/* Stopped short of SIZE at the end of user memory. */
+	return limit == size ? (int)size : -1;
+}
+
+/* If F is a kernel page fault at one of the instructions in the
+ * exception table, sets F up to resume at its fixup address and
+ * returns true.  Otherwise returns false.  The table has only a
+ * handful of entries, so it is searched linearly. */
+bool uaccess_fixup(struct intr_frame *f)
+{
+	const struct exception_entry *e;
+
+	for (e = __start_ex_table; e < __stop_ex_table; e++)
+	{
+		if (e->insn == f->rip)
+		{
+			f->rip = e->fixup;
+			return true;
+		}
+	}
+	return false;
+}
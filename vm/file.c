@@ -67,7 +67,7 @@ do_mmap(void *addr, size_t length, int writable,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		struct aux_val *lazy_load_arg = (struct aux_val *)malloc(sizeof(struct aux_val));
+		struct aux_val *lazy_load_arg = aux_val_alloc();
 		lazy_load_arg->file = file;
 		lazy_load_arg->offset = offset;
 		lazy_load_arg->read_bytes = page_read_bytes;
@@ -100,7 +100,7 @@ void do_munmap(void *addr)
 
 		if (pml4_is_dirty(thread_current()->pml4, page->va))
 		{
-			file_write_at(aux->file, addr, aux->read_bytes, aux->offset);
+			file_write_at(aux->file, page->frame->kva, aux->read_bytes, aux->offset);
 			pml4_set_dirty(thread_current()->pml4, page->va, 0);
 		}
 
@@ -127,7 +127,7 @@ static bool lazy_load_segment_for_mmap(struct page *page, void *aux)
 	if (file_read(file, kpage, page_read_bytes) != (int)page_read_bytes)
 	{
 		palloc_free_page(kpage);
-		free(lazy_load_arg);
+		aux_val_free(lazy_load_arg);
 		return false;
 	}
 	memset(kpage + page_read_bytes, 0, page_zero_bytes);
@@ -0,0 +1,260 @@
+/* text.c: Read-only executable pages shared between processes.
+ *
+ * Every process that runs an executable needs the same contents
+ * in the executable's read-only segments.  Rather than each
+ * process reading its own copy, the first process to touch a
+ * page of them loads it into a frame, and later processes that
+ * touch the same page of the same executable map that frame too.
+ * A frame is freed when the last process mapping it unmaps it.
+ *
+ * The executable cannot change underneath a shared frame: each
+ * frame holds the executable's inode open and denies writes to
+ * it until the frame is freed.  A forked child maps its parent's
+ * frames without opening the executable itself, so load()'s own
+ * deny_write is not enough once the parent exits. */
+
+#include "vm/vm.h"
+#include <ohash.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/mmu.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+static bool text_swap_in(struct page *page, void *kva);
+static void text_destroy(struct page *page);
+
+static const struct page_operations text_ops = {
+	.swap_in = text_swap_in,
+	.swap_out = NULL,
+	.destroy = text_destroy,
+	.type = VM_TEXT,
+};
+
+/* A frame holding one page of an executable. */
+struct text_frame
+{
+	struct ohash_elem elem; /* Element in text_frames. */
+	struct inode *inode;	/* Executable, held open. */
+	off_t ofs;				/* Offset of the page in the executable. */
+	size_t read_bytes;		/* Bytes read from it; the rest is zeros. */
+	void *kva;				/* The frame. */
+	int ref_cnt;			/* Number of pages mapping the frame. */
+};
+
+/* Shared frames, keyed by inode, offset and read_bytes, and the
+ * lock that protects them and their reference counts.  The lock
+ * is held while a missing frame is read in, so two processes
+ * faulting on the same page do not both load it. */
+static struct ohash text_frames;
+static struct lock text_lock;
+static struct kmem_cache *text_frame_cache;
+
+static uint64_t text_frame_hash(const struct ohash_elem *e, void *aux);
+static bool text_frame_less(const struct ohash_elem *a,
+							const struct ohash_elem *b, void *aux);
+
+/* Initializes the shared text frames. */
+void vm_text_init(void)
+{
+	ohash_init(&text_frames, text_frame_hash, text_frame_less, NULL);
+	lock_init(&text_lock);
+	text_frame_cache = kmem_cache_create("text_frame",
+										 sizeof(struct text_frame), NULL);
+}
+
+/* Initializes PAGE as a text page.  The page's contents come
+ * from the shared frame, so the page's own initializer, if any,
+ * is never called. */
+bool text_initializer(struct page *page, enum vm_type type UNUSED,
+					  void *kva UNUSED)
+{
+	page->operations = &text_ops;
+	page->text.shared = NULL;
+	return true;
+}
+
+/* Returns the frame holding the page of AUX's executable that
+ * AUX describes, loading it if no process has it yet, and takes
+ * a reference to it.  Returns a null pointer if memory runs out
+ * or the executable cannot be read. */
+static struct text_frame *
+text_frame_get(struct aux_val *aux)
+{
+	struct text_frame key, *tf;
+	struct ohash_elem *e;
+
+	key.inode = file_get_inode(aux->file);
+	key.ofs = aux->offset;
+	key.read_bytes = aux->read_bytes;
+
+	lock_acquire(&text_lock);
+	e = ohash_find(&text_frames, &key.elem);
+	if (e != NULL)
+	{
+		tf = ohash_entry(e, struct text_frame, elem);
+		tf->ref_cnt++;
+		lock_release(&text_lock);
+		return tf;
+	}
+
+	tf = kmem_cache_alloc(text_frame_cache);
+	if (tf == NULL)
+		goto fail;
+	*tf = key;
+	tf->kva = palloc_get_page(PAL_USER);
+	if (tf->kva == NULL)
+		goto fail;
+	if (file_read_at(aux->file, tf->kva, tf->read_bytes, tf->ofs) != (off_t)tf->read_bytes)
+		goto fail;
+	memset((uint8_t *)tf->kva + tf->read_bytes, 0, PGSIZE - tf->read_bytes);
+	tf->inode = inode_reopen(tf->inode);
+	inode_deny_write(tf->inode);
+	tf->ref_cnt = 1;
+	ohash_insert(&text_frames, &tf->elem);
+	lock_release(&text_lock);
+	return tf;
+
+fail:
+	if (tf != NULL)
+	{
+		if (tf->kva != NULL)
+			palloc_free_page(tf->kva);
+		kmem_cache_free(text_frame_cache, tf);
+	}
+	lock_release(&text_lock);
+	return NULL;
+}
+
+/* Drops a reference to TF, freeing it along with its frame, and
+ * allowing writes to its executable again, if it was the last
+ * one. */
+static void
+text_frame_put(struct text_frame *tf)
+{
+	lock_acquire(&text_lock);
+	if (--tf->ref_cnt > 0)
+	{
+		lock_release(&text_lock);
+		return;
+	}
+	ohash_delete(&text_frames, &tf->elem);
+	lock_release(&text_lock);
+
+	palloc_free_page(tf->kva);
+	inode_allow_write(tf->inode);
+	inode_close(tf->inode);
+	kmem_cache_free(text_frame_cache, tf);
+}
+
+/* Maps PAGE, an uninitialized text page of the current process,
+ * read-only onto shared frame TF, taking over the caller's
+ * reference to TF.  On failure the reference is dropped. */
+static bool
+text_map(struct page *page, struct text_frame *tf)
+{
+	if (!pml4_set_page(thread_current()->pml4, page->va, tf->kva, false))
+	{
+		text_frame_put(tf);
+		return false;
+	}
+	text_initializer(page, VM_TEXT, tf->kva);
+	page->text.shared = tf;
+	return true;
+}
+
+/* Claims PAGE, an uninitialized text page of the current
+ * process, by mapping it onto the shared frame for its contents.
+ * The lazy loading information is not needed afterward. */
+bool vm_text_claim(struct page *page)
+{
+	struct aux_val *aux = page->uninit.aux;
+	struct text_frame *tf;
+
+	ASSERT(page_get_type(page) == VM_TEXT);
+	ASSERT(page->operations->type == VM_UNINIT);
+
+	tf = text_frame_get(aux);
+	if (tf == NULL || !text_map(page, tf))
+		return false;
+	aux_val_free(aux);
+	return true;
+}
+
+/* Gives the current process, during fork, a text page at the
+ * same address as SRC, which belongs to the parent, mapped onto
+ * the same frame.  The child maps it at once, so that it never
+ * loads a page through the parent's executable file, which the
+ * parent may close first. */
+bool vm_text_copy(struct page *src)
+{
+	struct text_frame *tf;
+
+	if (src->operations->type == VM_UNINIT)
+	{
+		tf = text_frame_get(src->uninit.aux);
+		if (tf == NULL)
+			return false;
+	}
+	else
+	{
+		tf = src->text.shared;
+		lock_acquire(&text_lock);
+		tf->ref_cnt++;
+		lock_release(&text_lock);
+	}
+
+	if (!vm_alloc_page_with_initializer(VM_TEXT, src->va, false, NULL, NULL))
+	{
+		text_frame_put(tf);
+		return false;
+	}
+	return text_map(spt_find_page(&thread_current()->spt, src->va), tf);
+}
+
+/* Text pages are mapped onto a frame that is already filled in,
+ * so there is nothing to read. */
+static bool
+text_swap_in(struct page *page UNUSED, void *kva UNUSED)
+{
+	return true;
+}
+
+/* Unmaps text page PAGE from the current process and drops its
+ * reference to the shared frame.  The mapping is removed first
+ * so that destroying the page table does not free the frame out
+ * from under the processes still using it. */
+static void
+text_destroy(struct page *page)
+{
+	struct text_page *text_page = &page->text;
+
+	pml4_clear_page(thread_current()->pml4, page->va);
+	text_frame_put(text_page->shared);
+}
+
+/* Returns a hash value for text frame E's key. */
+static uint64_t
+text_frame_hash(const struct ohash_elem *e, void *aux UNUSED)
+{
+	const struct text_frame *tf = ohash_entry(e, struct text_frame, elem);
+	uint64_t h = hash_bytes(&tf->inode, sizeof tf->inode);
+	h = h * 31 + hash_int(tf->ofs);
+	return h * 31 + hash_int(tf->read_bytes);
+}
+
+/* Orders text frames by inode, offset and read_bytes. */
+static bool
+text_frame_less(const struct ohash_elem *a_, const struct ohash_elem *b_,
+				void *aux UNUSED)
+{
+	const struct text_frame *a = ohash_entry(a_, struct text_frame, elem);
+	const struct text_frame *b = ohash_entry(b_, struct text_frame, elem);
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	return a->read_bytes < b->read_bytes;
+}
@@ -1,10 +1,16 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "threads/vaddr.h"
 
+/* Object caches for the structures allocated on every page fault. */
+static struct kmem_cache *page_cache;
+static struct kmem_cache *frame_cache;
+static struct kmem_cache *aux_cache;
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void vm_init(void)
@@ -17,6 +23,24 @@ void vm_init(void)
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
+	page_cache = kmem_cache_create("page", sizeof(struct page), NULL);
+	frame_cache = kmem_cache_create("frame", sizeof(struct frame), NULL);
+	aux_cache = kmem_cache_create("aux_val", sizeof(struct aux_val), NULL);
+	vm_text_init();
+}
+
+/* Allocates the lazy loading information for one page.
+ * Returns a null pointer if memory is not available. */
+struct aux_val *
+aux_val_alloc(void)
+{
+	return kmem_cache_alloc(aux_cache);
+}
+
+/* Frees AUX, which must have come from aux_val_alloc(). */
+void aux_val_free(struct aux_val *aux)
+{
+	kmem_cache_free(aux_cache, aux);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -55,7 +79,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		/* TODO: Create the page, fetch the initializer according to the VM type,
 		 * TODO: and then create "uninit" page struct by calling uninit_new. You
 		 * TODO: should modify the field after calling the uninit_new. */
-		struct page *page = (struct page *)malloc(sizeof(struct page));
+		struct page *page = kmem_cache_alloc(page_cache);
 
 		switch (VM_TYPE(type))
 		{
@@ -65,6 +89,9 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		case VM_FILE:
 			uninit_new(page, upage, init, type, aux, file_backed_initializer);
 			break;
+		case VM_TEXT:
+			uninit_new(page, upage, init, type, aux, text_initializer);
+			break;
 		}
 		page->write = writable;
 		/* TODO: Insert the page into the spt. */
@@ -81,11 +108,11 @@ spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 	/* TODO: Find struct page that corresponds to va from the given supplemental page table.
 	If fail, return NULL.*/
 	struct page p;
-	struct hash_elem *e;
+	struct ohash_elem *e;
 
 	p.va = pg_round_down(va);
-	e = hash_find(&spt->pages, &p.hash_elem);
-	return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
+	e = ohash_find(&spt->pages, &p.hash_elem);
+	return e != NULL ? ohash_entry(e, struct page, hash_elem) : NULL;
 }
 
 /* Insert PAGE into spt with validation. */
@@ -95,17 +122,12 @@ bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
 	/* TODO: Insert struct page into the given supplemental page table.
 	This function should checks that the virtual address does not exist
 	in the given supplemental page table. */
-	if (spt_find_page(spt, page->va))
-	{
-		return false;
-	}
-	hash_insert(&spt->pages, &page->hash_elem);
-	return true;
+	return ohash_insert(&spt->pages, &page->hash_elem) == NULL;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
-	if (!hash_delete(&spt->pages, &page->hash_elem))
+	if (!ohash_delete(&spt->pages, &page->hash_elem))
 	{
 		return;
 	}
@@ -141,7 +163,7 @@ vm_evict_frame(void)
 static struct frame *
 vm_get_frame(void)
 {
-	struct frame *frame = (struct frame *)malloc(sizeof(struct frame));
+	struct frame *frame = kmem_cache_alloc(frame_cache);
 	/* TODO: Fill this function. */
 
 	frame->kva = palloc_get_page(PAL_USER);
@@ -217,7 +239,7 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 void vm_dealloc_page(struct page *page)
 {
 	destroy(page);
-	free(page);
+	kmem_cache_free(page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -241,6 +263,9 @@ vm_do_claim_page(struct page *page)
 	{
 		return false;
 	}
+	/* Text pages share a frame with other processes. */
+	if (page_get_type(page) == VM_TEXT)
+		return vm_text_claim(page);
 	struct frame *frame = vm_get_frame();
 	/* Set links */
 	frame->page = page;
@@ -261,22 +286,27 @@ void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 	You may choose the data structure to use for the supplemental page table.
 	The function is called when a new process starts (in initd of userprog/process.c)
 	and when a process is being forked (in __do_fork of userprog/process.c). */
-	hash_init(&spt->pages, page_hash, page_less, NULL);
+	ohash_init(&spt->pages, page_hash, page_less, NULL);
 }
 
 /* Copy supplemental page table from src to dst */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 								  struct supplemental_page_table *src UNUSED)
 {
-	struct hash_iterator i;
+	struct ohash_iterator i;
 
-	hash_first(&i, &src->pages);
-	while (hash_next(&i))
+	ohash_first(&i, &src->pages);
+	while (ohash_next(&i))
 	{
-		struct page *src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
+		struct page *src_page = ohash_entry(ohash_cur(&i), struct page, hash_elem);
 		enum vm_type type = page_get_type(src_page);
 
-		if (src_page->operations->type == VM_UNINIT)
+		if (type == VM_TEXT)
+		{
+			if (!vm_text_copy(src_page))
+				return false;
+		}
+		else if (src_page->operations->type == VM_UNINIT)
 		{
 			struct uninit_page *uninit_page = &src_page->uninit;
 
@@ -302,29 +332,29 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
-	hash_clear(&spt->pages, hash_action_destroy);
+	ohash_clear(&spt->pages, hash_action_destroy);
 }
 
-void hash_action_destroy(struct hash_elem *hash_elem_, void *aux)
+void hash_action_destroy(struct ohash_elem *hash_elem_, void *aux)
 {
-	struct page *page = hash_entry(hash_elem_, struct page, hash_elem);
+	struct page *page = ohash_entry(hash_elem_, struct page, hash_elem);
 	vm_dealloc_page(page);
 }
 
 /* Returns a hash value for page p. */
-unsigned
-page_hash(const struct hash_elem *p_, void *aux UNUSED)
+uint64_t
+page_hash(const struct ohash_elem *p_, void *aux UNUSED)
 {
-	const struct page *p = hash_entry(p_, struct page, hash_elem);
+	const struct page *p = ohash_entry(p_, struct page, hash_elem);
 	return hash_bytes(&p->va, sizeof p->va);
 }
 
 /* Returns true if page a precedes page b. */
-bool page_less(const struct hash_elem *a_,
-			   const struct hash_elem *b_, void *aux UNUSED)
+bool page_less(const struct ohash_elem *a_,
+			   const struct ohash_elem *b_, void *aux UNUSED)
 {
-	const struct page *a = hash_entry(a_, struct page, hash_elem);
-	const struct page *b = hash_entry(b_, struct page, hash_elem);
+	const struct page *a = ohash_entry(a_, struct page, hash_elem);
+	const struct page *b = ohash_entry(b_, struct page, hash_elem);
 
 	return a->va < b->va;
 }